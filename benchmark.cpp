@@ -0,0 +1,1382 @@
+#include "bst.h"
+#include "pool_allocator.h"
+#include "btree.h"
+#include "frozen_bst.h"
+#include "concurrent_bst.h"
+#include "persistent_bst.h"
+#include "bst_map.h"
+#include "bst_multiset.h"
+#include "compact_bst.h"
+#include "bst_file.h"
+#include "benchmark.h"
+
+#include<iostream>
+#include<chrono>
+#include<cmath>
+#include<cstdlib>
+#include<random>
+#include<memory>
+#include<vector>
+#include<numeric>
+#include<algorithm>
+#include<string>
+#include<string_view>
+#include<thread>
+#include<mutex>
+#include<set>
+#include<map>
+#include<cstdint>
+#include<cstdio>
+#include<fstream>
+
+/**
+function inserts keys 0..n-1 in sorted order and reports timing and height
+@param name label printed with the results
+@param n number of keys to insert
+*/
+template <typename tree_type>
+void sorted_insert(const char* name, size_t n) {
+
+	tree_type tree; // tree under test
+
+	double s = seconds([&] {
+		for (size_t i = 0; i < n; ++i) {
+			tree.insert(static_cast<int>(i)); // worst case for an unbalanced bst
+		}
+	});
+
+	std::cout << name << " sorted insert n=" << n
+		<< " time=" << s << "s"
+		<< " ns/op=" << s * 1e9 / n
+		<< " height=" << tree.height()
+		<< " log2(n)=" << std::log2(static_cast<double>(n)) << '\n';
+}
+
+/**
+function fills a tree with random keys, then repeatedly erases and
+inserts random keys, and finally times destruction of the tree
+@param name label printed with the results
+@param n number of keys kept in the tree
+@param ops number of erase/insert pairs
+*/
+template <typename tree_type>
+void churn(const char* name, size_t n, size_t ops) {
+
+	std::mt19937 gen(7); // fixed seed so every tree sees the same keys
+	int range = static_cast<int>(n * 2); // keys drawn from [0, 2n)
+
+	auto tree = std::make_unique<tree_type>(); // tree under test
+
+	double fill = seconds([&] {
+		while (tree->size() < n) {
+			tree->insert(static_cast<int>(gen() % range));
+		}
+	});
+
+	double mix = seconds([&] {
+		for (size_t i = 0; i < ops; ++i) {
+
+			auto it = tree->find(static_cast<int>(gen() % range)); // erase a key if present
+
+			if (it != tree->end()) {
+				tree->erase(it);
+			}
+
+			tree->insert(static_cast<int>(gen() % range)); // insert a key if absent
+		}
+	});
+
+	double teardown = seconds([&] { tree.reset(); });
+
+	std::cout << name << " churn n=" << n
+		<< " fill ns/op=" << fill * 1e9 / n
+		<< " erase+insert ns/op=" << mix * 1e9 / ops
+		<< " destroy=" << teardown * 1e3 << "ms" << '\n';
+}
+
+/**
+function times copy construction of a tree of n keys
+@param name label printed with the results
+@param n number of keys in the tree
+*/
+template <typename tree_type>
+void copy(const char* name, size_t n) {
+
+	std::mt19937 gen(11); // fixed seed
+	tree_type tree; // tree to copy
+
+	while (tree.size() < n) {
+		tree.insert(static_cast<int>(gen()));
+	}
+
+	size_t copied = 0; // keeps the copy from being optimized away
+
+	double s = seconds([&] {
+		tree_type snapshot = tree;
+		copied = snapshot.size();
+	});
+
+	std::cout << name << " copy n=" << copied
+		<< " time=" << s * 1e3 << "ms"
+		<< " ns/element=" << s * 1e9 / n << '\n';
+}
+
+/**
+function compares building a tree from n sorted keys with bulk
+assign against repeated insert
+@param n number of keys
+*/
+void bulk_load(size_t n) {
+
+	std::vector<int> keys(n); // sorted input
+	std::iota(keys.begin(), keys.end(), 0);
+
+	binarysearch::bst<int> inserted; // built one insert at a time
+
+	double insert_s = seconds([&] {
+		for (int k : keys) {
+			inserted.insert(k);
+		}
+	});
+
+	binarysearch::bst<int> tagged; // built from a range known to be sorted
+
+	double tagged_s = seconds([&] {
+		tagged.assign(binarysearch::sorted_unique, keys.begin(), keys.end());
+	});
+
+	binarysearch::bst<int> checked; // built from a range checked for order
+
+	double checked_s = seconds([&] {
+		checked.assign(keys.begin(), keys.end());
+	});
+
+	std::cout << "bulk load n=" << n
+		<< " insert=" << insert_s * 1e3 << "ms (height " << inserted.height() << ")"
+		<< " sorted_unique=" << tagged_s * 1e3 << "ms (height " << tagged.height() << ")"
+		<< " checked=" << checked_s * 1e3 << "ms" << '\n';
+}
+
+/**
+function compares string lookups that build a std::string key per probe
+with transparent lookups through std::string_view
+@param n number of keys
+*/
+void transparent_find(size_t n) {
+
+	std::vector<std::string> keys; // long enough to defeat the small string buffer
+	for (size_t i = 0; i < n; ++i) {
+		keys.push_back("request-path/segment/" + std::to_string(i));
+	}
+
+	binarysearch::bst<std::string, std::less<>> tree(keys.begin(), keys.end());
+	std::vector<std::string_view> probes(keys.begin(), keys.end()); // views into keys
+
+	size_t found = 0; // keeps lookups from being optimized away
+
+	double owning = seconds([&] {
+		for (std::string_view p : probes) {
+			found = found + tree.count(std::string(p)); // allocates a key
+		}
+	});
+
+	double viewing = seconds([&] {
+		for (std::string_view p : probes) {
+			found = found + tree.count(p); // compares against the view
+		}
+	});
+
+	std::cout << "string find n=" << n
+		<< " std::string key ns/op=" << owning * 1e9 / n
+		<< " string_view key ns/op=" << viewing * 1e9 / n
+		<< " (found " << found << ")" << '\n';
+}
+
+/**
+function compares counting a narrow key window by scanning from begin()
+with visit_range, which descends straight to the window
+@param n number of keys
+@param queries number of windows
+*/
+void range_query(size_t n, size_t queries) {
+
+	binarysearch::bst<int> tree; // keys 0, 2, 4, ...
+	for (size_t i = 0; i < n; ++i) {
+		tree.insert(static_cast<int>(i * 2));
+	}
+
+	std::mt19937 gen(3); // fixed seed
+	std::vector<int> lows(queries); // window starts
+	for (int& low : lows) {
+		low = static_cast<int>(gen() % (n * 2));
+	}
+
+	const int width = 200; // window width, about 100 keys
+
+	size_t scanned = 0; // elements counted by full scans
+
+	double scan = seconds([&] {
+		for (int low : lows) {
+			for (int v : tree) {
+				scanned = scanned + (v >= low && v < low + width);
+			}
+		}
+	});
+
+	size_t visited = 0; // elements counted by visit_range
+
+	double ranged = seconds([&] {
+		for (int low : lows) {
+			tree.visit_range(low, low + width, [&visited](int) { visited = visited + 1; });
+		}
+	});
+
+	std::cout << "range query n=" << n
+		<< " full scan us/query=" << scan * 1e6 / queries
+		<< " visit_range us/query=" << ranged * 1e6 / queries
+		<< " (matched " << scanned << "/" << visited << ")" << '\n';
+}
+
+/**
+function compares extracting the p50 and p99 elements by stepping an
+iterator with extracting them through nth on an order-statistics tree
+@param n number of keys
+*/
+void percentiles(size_t n) {
+
+	std::mt19937 gen(5); // fixed seed
+	binarysearch::bst<int, std::less<int>, binarysearch::red_black,
+		std::allocator<int>, binarysearch::order_statistics> tree;
+
+	while (tree.size() < n) {
+		tree.insert(static_cast<int>(gen()));
+	}
+
+	const int rounds = 10; // extractions of each kind
+	long long checksum = 0; // keeps results from being optimized away
+
+	double linear = seconds([&] {
+		for (int r = 0; r < rounds; ++r) {
+
+			auto it = tree.begin();
+			size_t i = 0;
+
+			for (; i < n / 2; ++i, ++it) {} // walk to p50
+			checksum = checksum + *it;
+
+			for (; i < n * 99 / 100; ++i, ++it) {} // walk on to p99
+			checksum = checksum + *it;
+		}
+	});
+
+	double ranked = seconds([&] {
+		for (int r = 0; r < rounds; ++r) {
+			checksum = checksum + *tree.nth(n / 2);
+			checksum = checksum + *tree.nth(n * 99 / 100);
+		}
+	});
+
+	std::cout << "percentiles n=" << n
+		<< " iterate us/query=" << linear * 1e6 / rounds
+		<< " nth us/query=" << ranked * 1e6 / rounds
+		<< " (checksum " << checksum << ")" << '\n';
+}
+
+/**
+function times random successful lookups
+@param name label printed with the results
+@param n number of keys
+*/
+template <typename tree_type>
+void lookup(const char* name, size_t n) {
+
+	std::mt19937 gen(9); // fixed seed
+	std::vector<int> keys; // inserted keys, reused as probes
+	tree_type tree; // tree under test
+
+	while (tree.size() < n) {
+
+		int k = static_cast<int>(gen());
+
+		if (tree.insert(k).second) {
+			keys.push_back(k);
+		}
+	}
+
+	std::shuffle(keys.begin(), keys.end(), gen); // random probe order
+
+	const size_t probes = 2000000; // lookups timed
+	size_t found = 0; // keeps lookups from being optimized away
+
+	double s = seconds([&] {
+		for (size_t i = 0; i < probes; ++i) {
+			found = found + tree.count(keys[i % n]);
+		}
+	});
+
+	std::cout << name << " lookup n=" << n
+		<< " ns/op=" << s * 1e9 / probes
+		<< " Mops/s=" << probes / s / 1e6
+		<< " (found " << found << ")" << '\n';
+}
+
+/**
+function compares bst::find with a frozen_bst snapshot under uniform
+and zipf(0.99) probe distributions
+@param n number of keys
+*/
+void snapshot_lookup(size_t n) {
+
+	std::mt19937 gen(13); // fixed seed
+	std::vector<int> keys; // inserted keys
+	binarysearch::bst<int> tree; // mutable tree
+
+	while (tree.size() < n) {
+
+		int k = static_cast<int>(gen());
+
+		if (tree.insert(k).second) {
+			keys.push_back(k);
+		}
+	}
+
+	std::shuffle(keys.begin(), keys.end(), gen); // hot keys land anywhere in the tree
+
+	double freeze_s = 0; // time to build the snapshot
+	binarysearch::frozen_bst<int> frozen;
+	freeze_s = seconds([&] { frozen = binarysearch::freeze(tree); });
+
+	const size_t probes = 2000000; // lookups per distribution
+	std::vector<int> uniform(probes); // uniform probe keys
+	std::vector<int> skewed(probes); // zipf probe keys
+	zipf_distribution zipf(n, 0.99);
+
+	for (size_t i = 0; i < probes; ++i) {
+		uniform[i] = keys[gen() % n];
+		skewed[i] = keys[zipf(gen)];
+	}
+
+	size_t found = 0; // keeps lookups from being optimized away
+
+	for (auto* probe : { &uniform, &skewed }) {
+
+		double tree_s = seconds([&] {
+			for (int k : *probe) {
+				found = found + (tree.find(k) != tree.end());
+			}
+		});
+
+		double frozen_s = seconds([&] {
+			for (int k : *probe) {
+				found = found + (frozen.find(k) != frozen.end());
+			}
+		});
+
+		std::cout << "snapshot n=" << n << (probe == &uniform ? " uniform" : " zipf   ")
+			<< " bst::find ns/op=" << tree_s * 1e9 / probes
+			<< " frozen_bst::find ns/op=" << frozen_s * 1e9 / probes << '\n';
+	}
+
+	std::cout << "snapshot n=" << n << " freeze=" << freeze_s * 1e3 << "ms"
+		<< " (found " << found << ")" << '\n';
+}
+
+/**
+function compares batches of lookups through find_many with a loop of
+find, for unsorted and sorted batches of growing size
+@param n number of keys in the tree
+*/
+void batch_lookup(size_t n) {
+
+	using tree_type = binarysearch::bst<int>;
+
+	std::mt19937 gen(17); // fixed seed
+	std::vector<int> keys; // inserted keys
+	tree_type tree; // tree under test
+
+	while (tree.size() < n) {
+
+		int k = static_cast<int>(gen());
+
+		if (tree.insert(k).second) {
+			keys.push_back(k);
+		}
+	}
+
+	const size_t total = 1 << 20; // keys looked up per measurement
+	std::vector<tree_type::iterator> results(1024, tree.end()); // reused output buffer
+	size_t found = 0; // keeps lookups from being optimized away
+
+	for (size_t batch = 1; batch <= 1024; batch = batch * 4) {
+
+		std::vector<int> probes(total); // random successful probes
+		for (int& p : probes) {
+			p = keys[gen() % n];
+		}
+
+		for (bool sorted : { false, true }) {
+
+			if (sorted) { // sort within each batch
+				for (size_t i = 0; i < total; i += batch) {
+					std::sort(probes.begin() + i, probes.begin() + i + batch);
+				}
+			}
+
+			double loop = seconds([&] {
+				for (int p : probes) {
+					found = found + (tree.find(p) != tree.end());
+				}
+			});
+
+			double batched = seconds([&] {
+				for (size_t i = 0; i < total; i += batch) {
+					tree.find_many(probes.begin() + i, probes.begin() + i + batch, results.begin());
+					found = found + (results[0] != tree.end());
+				}
+			});
+
+			std::cout << "find_many n=" << n << " batch=" << batch << (sorted ? " sorted  " : " unsorted")
+				<< " find loop ns/key=" << loop * 1e9 / total
+				<< " find_many ns/key=" << batched * 1e9 / total << '\n';
+		}
+	}
+
+	std::cout << "(found " << found << ")" << '\n';
+}
+
+/**
+function runs threads that mostly look up random keys and occasionally
+insert or erase one, and reports reads per second
+@param tree_name name printed with the results
+@param find lookup of one key, safe to call from any thread
+@param write insert (true) or erase (false) of one key, likewise
+@param n keys are drawn from [0, 2n)
+@param threads number of threads
+@param write_percent share of operations that write
+*/
+template <typename Find, typename Write>
+void read_mix(const char* tree_name, Find find, Write write, size_t n, unsigned threads, unsigned write_percent) {
+
+	const size_t ops = 200000; // operations per thread
+	std::atomic<size_t> reads(0); // lookups done by all threads
+	std::atomic<size_t> hits(0); // keeps lookups from being optimized away
+
+	double s = seconds([&] {
+
+		std::vector<std::thread> pool; // running threads
+
+		for (unsigned t = 0; t < threads; ++t) {
+			pool.emplace_back([&, t] {
+
+				std::mt19937 gen(100 + t); // per-thread stream
+				size_t r = 0; // lookups done by this thread
+				size_t h = 0; // hits of this thread
+
+				for (size_t i = 0; i < ops; ++i) {
+
+					int k = static_cast<int>(gen() % (2 * n)); // random key
+
+					if (gen() % 100 < write_percent) {
+						write(k, gen() % 2 == 0);
+					}
+					else {
+						h = h + find(k);
+						++r;
+					}
+				}
+
+				reads += r;
+				hits += h;
+			});
+		}
+
+		for (std::thread& th : pool) {
+			th.join();
+		}
+	});
+
+	std::cout << tree_name << " n=" << n << " threads=" << threads << " writes=" << write_percent << "%"
+		<< " reads/s=" << reads / s << " (hits " << hits << ")" << '\n';
+}
+
+/**
+function compares concurrent_bst with a bst behind one mutex as threads
+are added, for a read-only and two read-mostly workloads
+@param n number of keys in each tree
+*/
+void concurrent_reads(size_t n) {
+
+	unsigned most = std::thread::hardware_concurrency(); // available cores
+	most = most < 4 ? 4 : most; // still show oversubscription on small machines
+
+	binarysearch::concurrent_bst<int> shared; // lock-free readers
+	binarysearch::bst<int> locked; // every access under one mutex
+	std::mutex lock; // guards locked
+
+	std::mt19937 gen(3); // fixed seed
+	while (shared.size() < n) {
+
+		int k = static_cast<int>(gen() % (2 * n));
+		shared.insert(k);
+		locked.insert(k);
+	}
+
+	auto shared_find = [&](int k) { return shared.contains(k); };
+	auto shared_write = [&](int k, bool add) { add ? (void)shared.insert(k) : (void)shared.erase(k); };
+
+	auto locked_find = [&](int k) {
+		std::lock_guard<std::mutex> guard(lock);
+		return locked.contains(k);
+	};
+	auto locked_write = [&](int k, bool add) {
+		std::lock_guard<std::mutex> guard(lock);
+		add ? (void)locked.insert(k) : (void)locked.erase(k);
+	};
+
+	for (unsigned write_percent : { 0u, 1u, 10u }) {
+		for (unsigned threads = 1; threads <= most; threads = threads * 2) {
+			read_mix("concurrent_bst", shared_find, shared_write, n, threads, write_percent);
+			read_mix("bst + mutex   ", locked_find, locked_write, n, threads, write_percent);
+		}
+	}
+}
+
+/**
+function compares taking a snapshot of a persistent_bst with copying a
+bst, then applies the same random updates to each while the snapshot is
+held, and scans the snapshot
+@param n number of keys in each tree
+*/
+void snapshots(size_t n) {
+
+	std::mt19937 gen(5); // fixed seed
+	std::vector<int> keys(n); // inserted keys
+	for (int& k : keys) {
+		k = static_cast<int>(gen());
+	}
+
+	binarysearch::bst<int> mutable_tree(keys.begin(), keys.end()); // copied for each snapshot
+	binarysearch::persistent_bst<int> version; // shared for each snapshot
+	for (int k : keys) {
+		version = version.insert(k);
+	}
+
+	const size_t taken = 1000; // snapshots taken of the persistent tree
+	std::vector<binarysearch::persistent_bst<int>> held; // keeps every snapshot alive
+	held.reserve(taken);
+
+	double share = seconds([&] {
+		for (size_t i = 0; i < taken; ++i) {
+			held.push_back(version);
+		}
+	});
+
+	std::unique_ptr<binarysearch::bst<int>> copied; // one snapshot of the mutable tree
+	double copy = seconds([&] { copied.reset(new binarysearch::bst<int>(mutable_tree)); });
+
+	std::vector<int> updates(n / 10); // keys toggled in both trees
+	for (int& k : updates) {
+		k = gen() % 2 ? keys[gen() % n] : static_cast<int>(gen());
+	}
+
+	double persistent_updates = seconds([&] {
+		for (int k : updates) {
+			version = version.contains(k) ? version.erase(k) : version.insert(k);
+		}
+	});
+
+	double mutable_updates = seconds([&] {
+		for (int k : updates) {
+			mutable_tree.contains(k) ? (void)mutable_tree.erase(k) : (void)mutable_tree.insert(k);
+		}
+	});
+
+	long long sum = 0; // keeps the scan from being optimized away
+	double scan = seconds([&] {
+		for (int k : held.back()) {
+			sum = sum + k;
+		}
+	});
+
+	std::cout << "snapshot n=" << n << " persistent_bst share us=" << share * 1e6 / taken
+		<< " bst copy us=" << copy * 1e6 << '\n';
+	std::cout << "snapshot n=" << n << " updates=" << updates.size()
+		<< " persistent_bst ns/update=" << persistent_updates * 1e9 / updates.size()
+		<< " bst ns/update=" << mutable_updates * 1e9 / updates.size()
+		<< " snapshot scan s=" << scan << " (sum " << sum << ")" << '\n';
+}
+
+/**
+function merges two random trees of n elements by inserting one into the
+other and by union_with on one thread and on every core, then times
+intersect, difference and a parallel_reduce sum the same way
+@param n number of elements in each tree
+*/
+void set_operations(size_t n) {
+
+	using tree_type = binarysearch::bst<int>;
+
+	std::mt19937 gen(11); // fixed seed
+	tree_type a; // first operand
+	tree_type b; // second operand, overlapping about half of a
+
+	while (a.size() < n) {
+		a.insert(static_cast<int>(gen() % (4 * n)));
+	}
+	while (b.size() < n) {
+		b.insert(static_cast<int>(gen() % (4 * n)));
+	}
+
+	std::vector<unsigned> runs{ 1 }; // thread counts to time
+	if (std::thread::hardware_concurrency() > 1) {
+		runs.push_back(std::thread::hardware_concurrency());
+	}
+
+	{
+		tree_type x = a; // operands consumed by each run
+		tree_type y = b;
+
+		double s = seconds([&] {
+			for (int v : y) {
+				x.insert(v);
+			}
+		});
+
+		std::cout << "insert loop   n=" << n << " merge s=" << s << " size=" << x.size() << '\n';
+	}
+
+	for (unsigned threads : runs) {
+
+		tree_type x = a; // operands consumed by each run
+		tree_type y = b;
+		tree_type i = a;
+		tree_type d = a;
+
+		double merge = seconds([&] { x.union_with(y, threads); });
+		double common = seconds([&] { i.intersect(b, threads); });
+		double removed = seconds([&] { d.difference(b, threads); });
+
+		long long sum = 0; // sum of the union
+		double reduce = seconds([&] {
+			sum = x.parallel_reduce(0LL, [](int v) { return static_cast<long long>(v); },
+				[](long long l, long long r) { return l + r; }, threads);
+		});
+
+		std::cout << "union_with    n=" << n << " threads=" << threads << " union s=" << merge
+			<< " intersect s=" << common << " difference s=" << removed << " reduce s=" << reduce
+			<< " sizes=" << x.size() << "/" << i.size() << "/" << d.size() << " (sum " << sum << ")" << '\n';
+	}
+}
+
+/**
+function moves a tenth of a tree of strings to a second tree by copying
+and erasing, then by extract and node-handle insert, and merges the rest
+by merge against inserting copies
+@param n number of strings in the source tree
+*/
+void shard_moves(size_t n) {
+
+	using tree_type = binarysearch::bst<std::string>;
+
+	std::mt19937 gen(13); // fixed seed
+	std::vector<std::string> keys; // strings moved between the trees
+	tree_type source; // filled once, copied for each run
+
+	while (source.size() < n) {
+
+		std::string k = "payload-string-" + std::to_string(gen()); // beyond the small-string buffer
+		if (source.insert(k).second) {
+			keys.push_back(k);
+		}
+	}
+
+	std::shuffle(keys.begin(), keys.end(), gen);
+	keys.resize(n / 10);
+
+	tree_type copy_from = source; // operands of each run
+	tree_type copy_to;
+	tree_type extract_from = source;
+	tree_type extract_to;
+
+	double copied = seconds([&] {
+		for (const std::string& k : keys) {
+
+			auto it = copy_from.find(k);
+			copy_to.insert(*it);
+			copy_from.erase(it);
+		}
+	});
+
+	double relinked = seconds([&] {
+		for (const std::string& k : keys) {
+			extract_to.insert(extract_from.extract(k));
+		}
+	});
+
+	double inserted = seconds([&] {
+		for (const std::string& k : copy_from) {
+			copy_to.insert(k);
+		}
+		copy_from.clear();
+	});
+
+	double merged = seconds([&] { extract_to.merge(extract_from); });
+
+	std::cout << "shard move n=" << n << " moved=" << keys.size()
+		<< " copy+erase ns/elem=" << copied * 1e9 / keys.size()
+		<< " extract+insert ns/elem=" << relinked * 1e9 / keys.size() << '\n';
+	std::cout << "shard move n=" << n << " rest=" << extract_to.size() - keys.size()
+		<< " insert copies+clear s=" << inserted << " merge s=" << merged << '\n';
+}
+
+/**
+function inserts strings into trees where half the keys are already
+present, by insert of a constructed temporary against try_emplace, then
+appends ascending strings by insert against emplace_hint at end()
+@param n number of strings inserted per run
+*/
+void emplacing(size_t n) {
+
+	using tree_type = binarysearch::bst<std::string>;
+
+	std::mt19937 gen(17); // fixed seed
+	std::vector<std::string> keys(n); // half of them inserted up front
+
+	for (std::string& k : keys) {
+		k = "payload-string-" + std::to_string(gen()); // beyond the small-string buffer
+	}
+
+	tree_type base; // every other key already present
+	for (size_t i = 0; i < n; i += 2) {
+		base.insert(keys[i]);
+	}
+
+	tree_type inserted = base; // operands of each run
+	tree_type emplaced = base;
+
+	double by_insert = seconds([&] {
+		for (const std::string& k : keys) {
+			inserted.insert(std::string(k)); // temporary built even for a duplicate
+		}
+	});
+
+	double by_try_emplace = seconds([&] {
+		for (const std::string& k : keys) {
+			emplaced.try_emplace(k); // built only on a miss
+		}
+	});
+
+	std::sort(keys.begin(), keys.end());
+
+	tree_type appended; // filled in ascending order
+	tree_type hinted;
+
+	double by_append = seconds([&] {
+		for (const std::string& k : keys) {
+			appended.insert(k);
+		}
+	});
+
+	double by_hint = seconds([&] {
+		for (const std::string& k : keys) {
+			hinted.emplace_hint(hinted.end(), k);
+		}
+	});
+
+	std::cout << "emplace n=" << n << " half duplicates insert(T) s=" << by_insert
+		<< " try_emplace s=" << by_try_emplace << " (sizes " << inserted.size() << "/" << emplaced.size() << ")" << '\n';
+	std::cout << "emplace n=" << n << " ascending insert s=" << by_append
+		<< " emplace_hint(end) s=" << by_hint << " (sizes " << appended.size() << "/" << hinted.size() << ")" << '\n';
+}
+
+/**
+function counts zipf-distributed words, once in a bst of (word, count)
+pairs updated by erase and reinsert, and once in a bst_map through
+operator[]
+@param n number of distinct words
+@param updates number of counter increments
+*/
+void word_counts(size_t n, size_t updates) {
+
+	using entry = std::pair<std::string, size_t>;
+
+	// orders entries by word only
+	struct by_word {
+		bool operator()(const entry& a, const entry& b) const { return a.first < b.first; }
+	};
+
+	std::mt19937 gen(19); // fixed seed
+	zipf_distribution zipf(n, 0.99); // a few hot words
+	std::vector<std::string> words(n); // vocabulary
+	std::vector<size_t> stream(updates); // word index of each increment
+
+	for (std::string& w : words) {
+		w = "payload-word-" + std::to_string(gen()); // beyond the small-string buffer
+	}
+
+	for (size_t& i : stream) {
+		i = zipf(gen);
+	}
+
+	binarysearch::bst<entry, by_word> pairs; // the workaround
+	binarysearch::bst_map<std::string, size_t> map;
+
+	double reinserted = seconds([&] {
+		for (size_t i : stream) {
+
+			entry e(words[i], 1);
+			auto it = pairs.find(e);
+
+			if (it != pairs.end()) { // copy the count out, replace the entry
+				e.second = it->second + 1;
+				pairs.erase(it);
+			}
+
+			pairs.insert(std::move(e));
+		}
+	});
+
+	double indexed = seconds([&] {
+		for (size_t i : stream) {
+			++map[words[i]];
+		}
+	});
+
+	std::cout << "word counts n=" << n << " updates=" << updates
+		<< " pair erase+insert ns/op=" << reinserted * 1e9 / updates
+		<< " bst_map[] ns/op=" << indexed * 1e9 / updates
+		<< " (sizes " << pairs.size() << "/" << map.size() << ")" << '\n';
+}
+
+/**
+function inserts keys drawn from a small range, keeping duplicates, into
+a bst_multiset, into a bst with a side std::map of counts, and into a
+std::multiset, then counts every key
+@param n number of inserts
+@param distinct number of distinct keys
+*/
+void duplicates(size_t n, size_t distinct) {
+
+	std::mt19937 gen(23); // fixed seed
+	std::vector<int> keys(n); // inserted keys, many repeats
+
+	for (int& k : keys) {
+		k = static_cast<int>(gen() % distinct);
+	}
+
+	binarysearch::bst_multiset<int> multi; // one node per distinct key
+	binarysearch::bst<int> unique; // the workaround: set plus counts
+	std::map<int, size_t> side;
+	std::multiset<int> reference; // one node per insert
+
+	double by_multi = seconds([&] {
+		for (int k : keys) {
+			multi.insert(k);
+		}
+	});
+
+	double by_side = seconds([&] {
+		for (int k : keys) {
+			unique.insert(k);
+			++side[k];
+		}
+	});
+
+	double by_std = seconds([&] {
+		for (int k : keys) {
+			reference.insert(k);
+		}
+	});
+
+	size_t counted = 0; // keeps the counting loops alive
+
+	double count_multi = seconds([&] {
+		for (size_t k = 0; k < distinct; ++k) {
+			counted = counted + multi.count(static_cast<int>(k));
+		}
+	});
+
+	double count_std = seconds([&] {
+		for (size_t k = 0; k < distinct; ++k) {
+			counted = counted + reference.count(static_cast<int>(k));
+		}
+	});
+
+	std::cout << "duplicates n=" << n << " distinct=" << distinct
+		<< " insert bst_multiset s=" << by_multi << " bst+std::map s=" << by_side
+		<< " std::multiset s=" << by_std << " (nodes " << multi.distinct() << "/" << reference.size() << ")" << '\n';
+	std::cout << "duplicates n=" << n << " count all keys bst_multiset s=" << count_multi
+		<< " std::multiset s=" << count_std << " (total " << counted << ")" << '\n';
+}
+
+/**
+allocator that adds the bytes it hands out to a shared counter, to
+measure node storage
+*/
+template <typename T>
+struct counting_allocator {
+
+	using value_type = T;
+
+	explicit counting_allocator(size_t* counter) : bytes(counter) {}
+
+	template <typename U>
+	counting_allocator(const counting_allocator<U>& other) : bytes(other.bytes) {}
+
+	T* allocate(size_t n) {
+		*bytes = *bytes + n * sizeof(T);
+		return std::allocator<T>().allocate(n);
+	}
+
+	void deallocate(T* p, size_t n) {
+		*bytes = *bytes - n * sizeof(T);
+		std::allocator<T>().deallocate(p, n);
+	}
+
+	friend bool operator==(const counting_allocator& a, const counting_allocator& b) { return a.bytes == b.bytes; }
+	friend bool operator!=(const counting_allocator& a, const counting_allocator& b) { return a.bytes != b.bytes; }
+
+	size_t* bytes; // bytes currently allocated
+};
+
+/**
+function fills a bst and a compact_bst with the same keys, then reports
+node bytes per element and the time of a lookup of every key
+@param type_name label for the key type
+@param n number of keys
+@param make callable building the key for an integer
+*/
+template <typename T, typename Make>
+void node_layout(const char* type_name, size_t n, Make make) {
+
+	std::mt19937_64 gen(29); // fixed seed
+	std::vector<T> keys; // distinct keys, shuffled
+
+	for (size_t i = 0; i < n; ++i) {
+		keys.push_back(make(gen()));
+	}
+
+	size_t pointer_bytes = 0; // node storage of each tree
+	size_t index_bytes = 0;
+
+	binarysearch::bst<T, std::less<T>, binarysearch::red_black, counting_allocator<T>>
+		pointers{ counting_allocator<T>(&pointer_bytes) };
+	binarysearch::compact_bst<T, std::less<T>, counting_allocator<T>> indices{ counting_allocator<T>(&index_bytes) };
+
+	for (const T& k : keys) {
+		pointers.insert(k);
+		indices.insert(k);
+	}
+
+	std::shuffle(keys.begin(), keys.end(), gen);
+
+	size_t found = 0; // keeps the lookups alive
+
+	double by_pointer = seconds([&] {
+		for (const T& k : keys) {
+			found = found + pointers.count(k);
+		}
+	});
+
+	double by_index = seconds([&] {
+		for (const T& k : keys) {
+			found = found + indices.count(k);
+		}
+	});
+
+	std::cout << "node layout " << type_name << " n=" << pointers.size()
+		<< " bytes/elem bst=" << static_cast<double>(pointer_bytes) / pointers.size()
+		<< " compact_bst=" << static_cast<double>(index_bytes) / indices.size()
+		<< " lookup ns bst=" << by_pointer * 1e9 / keys.size()
+		<< " compact_bst=" << by_index * 1e9 / keys.size() << " (found " << found << ")" << '\n';
+}
+
+/**
+function restores a tree of random ints from a text dump by inserting one
+key at a time, from a binary file by load, and by mapping the binary file,
+then looks every key up in the loaded tree and in the mapping
+@param n number of keys
+*/
+void restart(size_t n) {
+
+	const char* text_path = "benchmark_restart.txt"; // scratch files, removed at the end
+	const char* binary_path = "benchmark_restart.bst";
+
+	std::mt19937 gen(31); // fixed seed
+	binarysearch::bst<int> tree; // the tree to restore
+
+	while (tree.size() < n) {
+		tree.insert(static_cast<int>(gen()));
+	}
+
+	double text_saved = seconds([&] {
+		std::ofstream out(text_path);
+		for (int k : tree) {
+			out << k << '\n';
+		}
+	});
+
+	double binary_saved = seconds([&] { binarysearch::save(tree, binary_path); });
+
+	binarysearch::bst<int> from_text; // restored trees
+	binarysearch::bst<int> from_binary;
+
+	double text_loaded = seconds([&] {
+		std::ifstream in(text_path);
+		for (int k; in >> k; ) {
+			from_text.insert(k);
+		}
+	});
+
+	double binary_loaded = seconds([&] { binarysearch::load(from_binary, binary_path); });
+
+	std::vector<int> keys(tree.begin(), tree.end()); // every key, shuffled
+	std::shuffle(keys.begin(), keys.end(), gen);
+
+	size_t found = 0; // keeps the lookups alive
+	double mapped_lookups = 0;
+
+	double mapped = seconds([&] {
+		binarysearch::mapped_bst<int> file(binary_path);
+		mapped_lookups = seconds([&] {
+			for (int k : keys) {
+				found = found + file.count(k);
+			}
+		});
+	});
+
+	double tree_lookups = seconds([&] {
+		for (int k : keys) {
+			found = found + from_binary.count(k);
+		}
+	});
+
+	std::remove(text_path);
+	std::remove(binary_path);
+
+	std::cout << "restart n=" << n << " save text s=" << text_saved << " binary s=" << binary_saved
+		<< " | restore text+insert s=" << text_loaded << " load s=" << binary_loaded
+		<< " map+lookups s=" << mapped << " (sizes " << from_text.size() << "/" << from_binary.size() << ")" << '\n';
+	std::cout << "restart n=" << n << " lookup all keys loaded bst s=" << tree_lookups
+		<< " mapped_bst s=" << mapped_lookups << " (found " << found << ")" << '\n';
+}
+
+/**
+function times random inserts, lookups and a full iteration on a plain
+tree and on one built with the statistics option, prints what the counters
+saw, and checks the height alert on an unbalanced tree fed sorted keys
+@param n number of keys
+*/
+void instrumentation(size_t n) {
+
+	std::mt19937 gen(41); // fixed seed
+	std::vector<int> keys(n); // random, with some repeats
+
+	for (int& k : keys) {
+		k = static_cast<int>(gen());
+	}
+
+	binarysearch::bst<int> plain;
+	binarysearch::bst<int, std::less<int>, binarysearch::red_black,
+		std::allocator<int>, binarysearch::statistics> counted;
+
+	size_t found = 0; // keeps the lookups alive
+
+	// inserts, lookups and one walk in order on either tree
+	auto work = [&](auto& tree) {
+		return seconds([&] {
+			for (int k : keys) {
+				tree.insert(k);
+			}
+			for (int k : keys) {
+				found = found + tree.count(k);
+			}
+			for (int k : tree) {
+				found = found + (k == 0);
+			}
+		});
+	};
+
+	double plain_time = work(plain);
+	double counted_time = work(counted);
+
+	binarysearch::bst_stats stats = counted.stats();
+	double ops = static_cast<double>(2 * n); // inserts and lookups
+
+	std::cout << "instrumentation n=" << n << " insert+find+iterate s plain=" << plain_time
+		<< " statistics=" << counted_time << " (found " << found << ")" << '\n';
+	std::cout << "instrumentation n=" << n << " cmp/op=" << stats.comparisons / ops
+		<< " mean probe=" << stats.mean_probe() << " height=" << stats.height
+		<< " (2*log2(n+1)=" << 2 * std::log2(static_cast<double>(stats.size) + 1) << ")"
+		<< " rotations/insert=" << stats.rotations / static_cast<double>(n)
+		<< " steps/element=" << stats.iterator_steps / static_cast<double>(stats.size)
+		<< " allocations=" << stats.allocations << " frees=" << stats.frees << '\n';
+
+	binarysearch::bst<int, std::less<int>, binarysearch::unbalanced,
+		std::allocator<int>, binarysearch::statistics> degenerate; // sorted input makes a list
+
+	for (int k = 0; k < 1000; ++k) {
+		degenerate.insert(k);
+	}
+
+	binarysearch::bst_stats drift = degenerate.stats();
+
+	std::cout << "instrumentation unbalanced sorted n=1000 height=" << drift.height
+		<< " exceeds 2*log2(n+1): " << (drift.height_exceeds(2) ? "yes" : "no")
+		<< " (red-black: " << (stats.height_exceeds(2) ? "yes" : "no") << ")" << '\n';
+}
+
+/**
+function times find on zipf(0.99), zipf(1.2) (1% of keys take 90% of the
+finds) and uniform traffic over n random keys,
+on the static red-black tree and on one under the frequency_weighted policy,
+and reports the mean number of nodes each lookup visited
+@param n number of keys
+@param lookups number of finds per traffic pattern
+*/
+void hot_keys(size_t n, size_t lookups) {
+
+	using static_tree = binarysearch::bst<int, std::less<int>, binarysearch::red_black,
+		std::allocator<int>, binarysearch::statistics>;
+	using weighted_tree = binarysearch::bst<int, std::less<int>, binarysearch::frequency_weighted,
+		std::allocator<int>, binarysearch::statistics>;
+
+	std::mt19937 gen(43); // fixed seed
+	std::vector<int> keys; // distinct, in random order
+
+	static_tree balanced;
+	while (balanced.size() < n) {
+		int k = static_cast<int>(gen());
+		if (balanced.insert(k).second) {
+			keys.push_back(k);
+		}
+	}
+
+	weighted_tree adaptive(keys.begin(), keys.end()); // starts perfectly balanced too
+
+	zipf_distribution zipf(n, 0.99); // ranks over the shuffled keys: hot keys are random ones
+	zipf_distribution steep(n, 1.2);
+	std::vector<int> skewed(lookups);
+	std::vector<int> steeper(lookups);
+	std::vector<int> uniform(lookups);
+
+	for (size_t i = 0; i < lookups; ++i) {
+		skewed[i] = keys[zipf(gen)];
+		steeper[i] = keys[steep(gen)];
+		uniform[i] = keys[gen() % n];
+	}
+
+	size_t found = 0; // keeps the lookups alive
+
+	for (const std::vector<int>* traffic : { &skewed, &steeper, &uniform }) {
+
+		balanced.reset_stats();
+		adaptive.reset_stats();
+
+		double static_time = seconds([&] {
+			for (int k : *traffic) {
+				found = found + (balanced.find(k) != balanced.end());
+			}
+		});
+
+		double weighted_time = seconds([&] {
+			for (int k : *traffic) {
+				found = found + (adaptive.find(k) != adaptive.end());
+			}
+		});
+
+		std::cout << "hot keys n=" << n << (traffic == &skewed ? " zipf0.99" : traffic == &steeper ? " zipf1.2 " : " uniform ")
+			<< " find ns static=" << static_time * 1e9 / lookups << " weighted=" << weighted_time * 1e9 / lookups
+			<< " | nodes/find static=" << balanced.stats().mean_probe() << " weighted=" << adaptive.stats().mean_probe()
+			<< " rotations/find=" << adaptive.stats().rotations / static_cast<double>(lookups)
+			<< " (found " << found << ")" << '\n';
+	}
+}
+
+/**
+function times full forward and reverse scans over n random ints in a bst,
+in a bst with the threaded option and in a std::set
+@param n number of keys
+@param rounds scans of each kind
+*/
+void scans(size_t n, int rounds) {
+
+	std::mt19937 gen(47); // fixed seed
+	std::vector<int> keys(n);
+
+	for (int& k : keys) {
+		k = static_cast<int>(gen());
+	}
+
+	binarysearch::bst<int> plain; // built by random inserts, so nodes are scattered
+	binarysearch::bst<int, std::less<int>, binarysearch::red_black,
+		std::allocator<int>, binarysearch::threaded> linked;
+	std::set<int> reference;
+
+	for (int k : keys) {
+		plain.insert(k);
+		linked.insert(k);
+		reference.insert(k);
+	}
+
+	long long checksum = 0; // keeps the reads alive
+
+	// ns per element of forward and of reverse scans over one container
+	auto scan = [&](const char* name, const auto& tree) {
+
+		double forward = seconds([&] {
+			for (int r = 0; r < rounds; ++r) {
+				for (auto it = tree.begin(); it != tree.end(); ++it) {
+					checksum = checksum + *it;
+				}
+			}
+		});
+
+		double reverse = seconds([&] {
+			for (int r = 0; r < rounds; ++r) {
+				for (auto it = tree.rbegin(); it != tree.rend(); ++it) {
+					checksum = checksum + *it;
+				}
+			}
+		});
+
+		double visits = static_cast<double>(tree.size()) * rounds;
+
+		std::cout << "scans n=" << n << " " << name << " forward ns/element=" << forward * 1e9 / visits
+			<< " reverse ns/element=" << reverse * 1e9 / visits << '\n';
+	};
+
+	scan("bst         ", plain);
+	scan("bst threaded", linked);
+	scan("std::set    ", reference);
+
+	std::cout << "scans n=" << n << " (checksum " << checksum << ")" << '\n';
+}
+
+int main(int argc, char** argv) {
+
+	// number of keys for the balanced tree (default 10M)
+	size_t n = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10000000;
+
+	// the unbalanced tree is quadratic on sorted input, so keep it small
+	size_t n_unbalanced = n < 20000 ? n : 20000;
+
+	sorted_insert<binarysearch::bst<int, std::less<int>, binarysearch::red_black>>("red_black ", n);
+	sorted_insert<binarysearch::bst<int, std::less<int>, binarysearch::unbalanced>>("unbalanced", n_unbalanced);
+
+	std::cout << '\n';
+
+	// global new/delete per node versus slab pool
+	churn<binarysearch::bst<int>>("std::allocator", n / 10, n);
+	churn<binarysearch::bst<int, std::less<int>, binarysearch::red_black,
+		binarysearch::pool_allocator<int>>>("pool_allocator", n / 10, n);
+
+	std::cout << '\n';
+
+	// structural clone, no comparator calls
+	copy<binarysearch::bst<int>>("red_black ", n / 10);
+
+	std::cout << '\n';
+
+	// linear-time balanced build from sorted input
+	bulk_load(n);
+
+	std::cout << '\n';
+
+	// heterogeneous lookup without constructing keys
+	transparent_find(n / 10);
+
+	std::cout << '\n';
+
+	// O(log n + k) window queries
+	range_query(n / 10, 100);
+
+	std::cout << '\n';
+
+	// O(log n) selection with subtree sizes
+	percentiles(n);
+
+	std::cout << '\n';
+
+	// pointer-per-level bst versus cache-line-sized B+ tree nodes
+	for (size_t size : { size_t(1000), n / 10, n }) {
+		lookup<binarysearch::bst<int>>("bst   ", size);
+		lookup<binarysearch::btree<int>>("btree ", size);
+	}
+
+	std::cout << '\n';
+
+	// read-only Eytzinger snapshot
+	snapshot_lookup(n);
+
+	std::cout << '\n';
+
+	// batched, interleaved lookups
+	batch_lookup(n);
+
+	std::cout << '\n';
+
+	// read-mostly scaling across threads
+	concurrent_reads(n);
+
+	std::cout << '\n';
+
+	// O(1) snapshots against copying
+	snapshots(n);
+
+	std::cout << '\n';
+
+	// join-based bulk set operations
+	set_operations(n);
+
+	std::cout << '\n';
+
+	// relinking nodes between trees
+	shard_moves(n);
+
+	std::cout << '\n';
+
+	// constructing only on a miss, hinted appends
+	emplacing(n / 10);
+
+	std::cout << '\n';
+
+	// counter updates in place
+	word_counts(n / 100, n);
+
+	std::cout << '\n';
+
+	// many inserts over few distinct keys
+	duplicates(n / 10, 1000);
+
+	std::cout << '\n';
+
+	// pointer links against 31-bit index links without parents
+	node_layout<int>("int     ", n, [](uint64_t r) { return static_cast<int>(r); });
+	node_layout<uint64_t>("uint64_t", n, [](uint64_t r) { return r; });
+	node_layout<std::string>("string  ", n / 10, [](uint64_t r) { return "payload-string-" + std::to_string(r); });
+
+	std::cout << '\n';
+
+	// restoring from disk
+	restart(n);
+
+	std::cout << '\n';
+
+	// counters under the statistics option
+	instrumentation(n);
+
+	std::cout << '\n';
+
+	// hot keys lifted toward the root
+	hot_keys(n, 2 * n);
+
+	std::cout << '\n';
+
+	// in-order links against parent climbing
+	for (size_t size : { n / 100, n }) {
+		scans(size, 10);
+	}
+
+	return 0;
+}
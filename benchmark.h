@@ -0,0 +1,70 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include<chrono>
+#include<cmath>
+#include<cstddef>
+#include<random>
+#include<vector>
+#include<algorithm>
+
+/**
+function times a callable
+@param f the work to time
+@return elapsed wall-clock seconds
+*/
+template <typename F>
+double seconds(F&& f) {
+
+	auto start = std::chrono::steady_clock::now(); // start time
+	f(); // run the work
+	auto stop = std::chrono::steady_clock::now(); // stop time
+
+	return std::chrono::duration<double>(stop - start).count();
+}
+
+/**
+zipf-distributed ranks in [0, n): rank r is drawn with probability
+proportional to 1 / (r + 1)^s, sampled by binary search over the CDF
+*/
+class zipf_distribution {
+
+public:
+
+	/**
+	* constructor which precomputes the cumulative distribution
+	* @param n number of ranks
+	* @param s skew exponent (0.99 is typical of request traffic)
+	*/
+	zipf_distribution(size_t n, double s) : cdf(n) {
+
+		double total = 0; // running sum of weights
+
+		for (size_t r = 0; r < n; ++r) {
+			total = total + 1.0 / std::pow(static_cast<double>(r + 1), s);
+			cdf[r] = total;
+		}
+
+		for (double& c : cdf) { // normalize to [0, 1]
+			c = c / total;
+		}
+	}
+
+	/**
+	* draws one rank
+	* @param gen random engine
+	* @return rank in [0, n)
+	*/
+	template <typename G>
+	size_t operator()(G& gen) {
+
+		double u = std::uniform_real_distribution<double>(0.0, 1.0)(gen);
+		size_t r = static_cast<size_t>(std::lower_bound(cdf.begin(), cdf.end(), u) - cdf.begin());
+		return r < cdf.size() ? r : cdf.size() - 1;
+	}
+
+private:
+	std::vector<double> cdf; // cumulative probability of each rank
+};
+
+#endif
@@ -0,0 +1,322 @@
+#include "bst.h"
+#include "benchmark.h"
+
+#include<iostream>
+#include<iomanip>
+#include<cstdlib>
+#include<cstdio>
+#include<cstdint>
+#include<fstream>
+#include<random>
+#include<vector>
+#include<algorithm>
+#include<string>
+#include<set>
+#include<utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include<sys/resource.h>
+#endif
+
+/**
+number of calls made by every counting_less
+*/
+size_t comparisons = 0;
+
+/**
+function object like std::less<T> that counts its calls in comparisons
+*/
+template <typename T>
+struct counting_less {
+
+	bool operator()(const T& a, const T& b) const {
+
+		comparisons = comparisons + 1;
+		return a < b;
+	}
+};
+
+/**
+function resets the peak resident set size so that each workload reports
+its own peak (Linux only; elsewhere the peak is that of the process)
+*/
+void reset_peak_rss() {
+
+	std::ofstream clear("/proc/self/clear_refs");
+
+	if (clear) {
+		clear << "5"; // reset VmHWM to the current RSS
+	}
+}
+
+/**
+function reads the peak resident set size
+@return peak RSS in MiB, or 0 if unknown
+*/
+double peak_rss_mib() {
+
+	std::ifstream status("/proc/self/status");
+
+	for (std::string line; std::getline(status, line); ) {
+		if (line.compare(0, 6, "VmHWM:") == 0) { // in kB
+			return std::strtod(line.c_str() + 6, nullptr) / 1024.0;
+		}
+	}
+
+#if defined(__unix__) || defined(__APPLE__)
+	rusage usage; // process-wide peak
+	getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+	return static_cast<double>(usage.ru_maxrss) / (1024.0 * 1024.0); // in bytes
+#else
+	return static_cast<double>(usage.ru_maxrss) / 1024.0; // in kB
+#endif
+#else
+	return 0;
+#endif
+}
+
+/**
+function builds the key of rank r; keys ascend with r (int keys for r up to INT_MAX)
+@param r rank of the key
+@return the key
+*/
+template <typename T>
+T make_key(uint32_t r);
+
+template <>
+int make_key<int>(uint32_t r) {
+	return static_cast<int>(r);
+}
+
+template <>
+std::string make_key<std::string>(uint32_t r) {
+
+	char buffer[32]; // zero-padded, so string order is rank order
+	std::snprintf(buffer, sizeof(buffer), "payload-string-%010u", static_cast<unsigned>(r));
+	return buffer; // beyond the small-string buffer
+}
+
+/**
+key orders a workload runs in
+*/
+enum class distribution { random, sorted, reverse, zipfian };
+
+const char* distribution_name(distribution d) {
+
+	switch (d) {
+	case distribution::random: return "random";
+	case distribution::sorted: return "sorted";
+	case distribution::reverse: return "reverse";
+	default: return "zipfian";
+	}
+}
+
+/**
+function builds the sequence of keys a workload inserts, finds and erases:
+n distinct keys shuffled, ascending or descending, or n zipf draws (with
+repeats) over a shuffled set of keys
+@param d the distribution
+@param n number of keys in the sequence
+@return the keys in workload order
+*/
+template <typename T>
+std::vector<T> make_stream(distribution d, size_t n) {
+
+	std::mt19937 gen(37); // fixed seed
+	std::vector<T> keys; // distinct keys, ascending
+	keys.reserve(n);
+
+	for (size_t i = 0; i < n; ++i) {
+		keys.push_back(make_key<T>(static_cast<uint32_t>(i * 21 + 7))); // spread, still ascending (below INT_MAX up to 100M)
+	}
+
+	if (d == distribution::sorted) {
+		return keys;
+	}
+
+	if (d == distribution::reverse) {
+		std::reverse(keys.begin(), keys.end());
+		return keys;
+	}
+
+	std::shuffle(keys.begin(), keys.end(), gen);
+
+	if (d == distribution::random) {
+		return keys;
+	}
+
+	// zipf over at most 1M ranks: the skew is the same and the CDF stays small
+	size_t ranks = n < 1000000 ? n : 1000000;
+	zipf_distribution zipf(ranks, 0.99);
+	std::vector<T> draws; // hot keys repeat
+	draws.reserve(n);
+
+	for (size_t i = 0; i < n; ++i) {
+		draws.push_back(keys[zipf(gen)]);
+	}
+
+	return draws;
+}
+
+/**
+accumulated cost of one operation across rounds
+*/
+struct op_cost {
+	double seconds = 0; // wall-clock time
+	size_t calls = 0; // comparator calls
+	size_t ops = 0; // operations timed
+};
+
+/**
+function times f, adding its time and comparator calls to cost
+@param cost running totals of the operation
+@param ops number of operations f performs
+@param f the work to time
+*/
+template <typename F>
+void measure(op_cost& cost, size_t ops, F&& f) {
+
+	size_t before = comparisons; // calls so far
+	cost.seconds = cost.seconds + seconds(std::forward<F>(f));
+	cost.calls = cost.calls + (comparisons - before);
+	cost.ops = cost.ops + ops;
+}
+
+/**
+function runs insert, emplace, find, iterate, copy, move and erase on one
+container type over one key stream, repeating small sizes so that each
+operation is timed over about a million calls, and prints one line per
+operation: ns/op, comparator calls per op, and the peak RSS of the workload
+@param set_name label of the container
+@param key_name label of the key type
+@param d the distribution of stream
+@param stream keys in workload order
+*/
+template <typename Set, typename T>
+void run(const char* set_name, const char* key_name, distribution d, const std::vector<T>& stream) {
+
+	size_t n = stream.size(); // operations per pass
+	size_t rounds = n < 1000000 ? 1000000 / n : 1; // passes, so small sizes are measurable
+
+	op_cost insert, emplace, find, iterate, copy, move, erase; // per operation totals
+	size_t checksum = 0; // keeps the reads alive
+
+	reset_peak_rss();
+
+	for (size_t round = 0; round < rounds; ++round) {
+
+		Set inserted; // filled by insert, then read, copied and erased
+		Set emplaced; // filled by emplace
+
+		measure(insert, n, [&] {
+			for (const T& k : stream) {
+				inserted.insert(k);
+			}
+		});
+
+		measure(emplace, n, [&] {
+			for (const T& k : stream) {
+				emplaced.emplace(k);
+			}
+		});
+
+		measure(find, n, [&] {
+			for (const T& k : stream) {
+				checksum = checksum + (inserted.find(k) != inserted.end());
+			}
+		});
+
+		measure(iterate, inserted.size(), [&] {
+			for (const T& k : inserted) {
+				checksum = checksum + sizeof(k);
+			}
+		});
+
+		Set* copied = nullptr; // built inside the timing, destroyed outside it
+		measure(copy, inserted.size(), [&] { copied = new Set(inserted); });
+
+		Set* moved = nullptr;
+		measure(move, 1, [&] { moved = new Set(std::move(*copied)); });
+
+		checksum = checksum + moved->size();
+		delete moved;
+		delete copied;
+
+		measure(erase, n, [&] {
+			for (const T& k : stream) {
+				checksum = checksum + inserted.erase(k);
+			}
+		});
+	}
+
+	double peak = peak_rss_mib(); // of this workload, where resettable
+
+	std::pair<const char*, const op_cost*> rows[] = {
+		{ "insert", &insert }, { "emplace", &emplace }, { "find", &find }, { "iterate", &iterate },
+		{ "copy", &copy }, { "move", &move }, { "erase", &erase }
+	};
+
+	for (const auto& row : rows) {
+
+		const op_cost& c = *row.second;
+		double ops = c.ops ? static_cast<double>(c.ops) : 1.0;
+
+		std::cout << std::left << std::setw(9) << set_name << std::setw(7) << key_name
+			<< std::setw(8) << distribution_name(d) << std::setw(11) << n << std::setw(8) << row.first
+			<< std::right << std::fixed << std::setprecision(1)
+			<< " ns/op=" << std::setw(9) << c.seconds * 1e9 / ops
+			<< " cmp/op=" << std::setw(6) << c.calls / ops
+			<< " peak_rss_mib=" << std::setw(8) << peak << '\n';
+	}
+
+	if (checksum == 0) { // never true; stops the reads from being optimized away
+		std::cout << '\n';
+	}
+}
+
+/**
+function runs every workload of one key type for bst and std::set
+@param key_name label of the key type
+@param sizes numbers of keys to run
+*/
+template <typename T>
+void run_key(const char* key_name, const std::vector<size_t>& sizes) {
+
+	using bst_type = binarysearch::bst<T, counting_less<T>>;
+	using set_type = std::set<T, counting_less<T>>;
+
+	for (size_t n : sizes) {
+		for (distribution d : { distribution::random, distribution::sorted, distribution::reverse, distribution::zipfian }) {
+
+			std::vector<T> stream = make_stream<T>(d, n);
+
+			run<bst_type>("bst", key_name, d, stream);
+			run<set_type>("std::set", key_name, d, stream);
+		}
+	}
+}
+
+int main(int argc, char** argv) {
+
+	// largest number of keys (default 1M); sizes go up by 10x from 1K to it
+	size_t max_size = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+
+	// "int" or "string" to run one key type only
+	std::string only = argc > 2 ? argv[2] : "";
+
+	std::vector<size_t> sizes; // 1K, 10K, ... up to max_size (100M at most)
+	for (size_t n = 1000; n <= max_size && n <= 100000000; n = n * 10) {
+		sizes.push_back(n);
+	}
+
+	if (only.empty() || only == "int") {
+		run_key<int>("int", sizes);
+	}
+
+	if (only.empty() || only == "string") {
+		run_key<std::string>("string", sizes);
+	}
+
+	return 0;
+}
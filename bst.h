@@ -4,25 +4,338 @@
 #include <utility>
 #include <functional>
 #include <stdexcept>
+#include <type_traits>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <iterator>
+#include <algorithm>
+#include <vector>
+#include <future>
+#include <thread>
+#include <system_error>
+#include <optional>
+#include <atomic>
+#include <array>
+#include <cmath>
 
 namespace binarysearch {
 
+	namespace detail {
+
+		/**
+		* hints that the cache line holding p will be read soon
+		* @param p address to prefetch (need not be dereferenceable)
+		*/
+		inline void prefetch(const void* p) {
+#if defined(__GNUC__) || defined(__clang__)
+			__builtin_prefetch(p);
+#else
+			(void)p;
+#endif
+		}
+
+		/**
+		* runs left and right, left on a new thread when parallel (and inline
+		* if no thread can be started); returns once both are done
+		* @param parallel whether to start a thread for left
+		* @param left work for the new thread
+		* @param right work for the calling thread
+		*/
+		template <typename F, typename G>
+		void fork(bool parallel, F&& left, G&& right) {
+
+			std::future<void> pending; // left, when it runs on its own thread
+
+			if (parallel) {
+				try {
+					pending = std::async(std::launch::async, std::forward<F>(left));
+				}
+				catch (const std::system_error&) { // out of threads: stay serial
+					parallel = false;
+				}
+			}
+
+			if (!parallel) {
+				left();
+			}
+
+			right();
+
+			if (pending.valid()) { // wait for left, passing on its exception
+				pending.get();
+			}
+		}
+
+		/**
+		* whether allocator A can free everything it handed out at once
+		* through a bool release() member (see pool_allocator)
+		*/
+		template <typename A, typename = void>
+		struct has_release : std::false_type {};
+
+		template <typename A>
+		struct has_release<A, decltype(void(std::declval<A&>().release()))> : std::true_type {};
+
+		/**
+		* whether comparator C accepts keys of other types than T
+		* (declares is_transparent, like std::less<>)
+		*/
+		template <typename C, typename = void>
+		struct is_transparent : std::false_type {};
+
+		template <typename C>
+		struct is_transparent<C, std::void_t<typename C::is_transparent>> : std::true_type {};
+
+		/**
+		* per-node size of the subtree rooted at the node, present only
+		* when order statistics are enabled (empty base otherwise)
+		*/
+		template <bool>
+		struct subtree_size {};
+
+		template <>
+		struct subtree_size<true> {
+			size_t count = 1; // nodes in this subtree, including this one
+		};
+
+		/**
+		* per-node links to the in-order neighbours, present only with the
+		* threaded option (empty base otherwise)
+		*/
+		template <bool, typename N>
+		struct order_links {};
+
+		template <typename N>
+		struct order_links<true, N> {
+			N* prev = nullptr; // in-order predecessor (null for the first node)
+			N* next = nullptr; // in-order successor (null for the last node)
+		};
+
+		/**
+		* per-node treap priority, present only under the frequency_weighted
+		* policy (empty base otherwise): hits in the high 32 bits above a hash
+		* of the node's address, which orders nodes used equally often
+		*/
+		template <bool>
+		struct access_weight {};
+
+		template <>
+		struct access_weight<true> {
+
+			static constexpr uint64_t hit = uint64_t(1) << 32; // weight of one access
+
+			uint64_t weight = tiebreak(reinterpret_cast<uintptr_t>(this));
+
+			// low 32 bits of the 64-bit murmur finalizer, spreading consecutive addresses
+			static uint64_t tiebreak(uint64_t x) {
+				x = (x ^ (x >> 33)) * 0xff51afd7ed558ccdULL;
+				x = (x ^ (x >> 33)) * 0xc4ceb9fe1a85ec53ULL;
+				return (x ^ (x >> 33)) & 0xffffffffULL;
+			}
+		};
+
+		/**
+		* operation counters of a tree built with the statistics option; the
+		* primary template is an empty base whose hooks compile to nothing
+		*/
+		template <bool>
+		struct tree_counters {
+			void countComparison() const {}
+			void countProbe(size_t) const {}
+			void countAllocation() const {}
+			void countFrees(size_t) const {}
+			void countRotation() const {}
+			void countStep() const {}
+		};
+
+		template <>
+		struct tree_counters<true> {
+
+			static constexpr size_t buckets = 64; // probe lengths kept apart; longer ones share the last
+
+			// relaxed atomics: const searches and the set operations' threads count concurrently
+			mutable std::atomic<size_t> comparisons{ 0 }; // comparator calls
+			mutable std::atomic<size_t> allocations{ 0 }; // nodes allocated
+			mutable std::atomic<size_t> frees{ 0 }; // nodes freed
+			mutable std::atomic<size_t> rotations{ 0 }; // rebalancing rotations
+			mutable std::atomic<size_t> steps{ 0 }; // links followed by iterator ++ and --
+			mutable std::atomic<size_t> probes[buckets]{}; // descents by nodes visited
+
+			void countComparison() const { comparisons.fetch_add(1, std::memory_order_relaxed); }
+			void countAllocation() const { allocations.fetch_add(1, std::memory_order_relaxed); }
+			void countFrees(size_t n) const { frees.fetch_add(n, std::memory_order_relaxed); }
+			void countRotation() const { rotations.fetch_add(1, std::memory_order_relaxed); }
+			void countStep() const { steps.fetch_add(1, std::memory_order_relaxed); }
+
+			void countProbe(size_t visited) const {
+				probes[visited < buckets ? visited : buckets - 1].fetch_add(1, std::memory_order_relaxed);
+			}
+		};
+	}
+
+	/**
+	* balancing policy: nodes are linked where the search ends and
+	* never rotated, so sorted input degrades the tree into a list
+	*/
+	struct unbalanced {};
+
+	/**
+	* balancing policy: red-black recoloring and rotations after every
+	* insert and erase keep the height below 2 * log2(size + 1)
+	*/
+	struct red_black {};
+
+	/**
+	* balancing policy: a treap ordered by access counts; a non-const find
+	* that hits counts the access, rotates the node above every parent used
+	* less often and stops descending at the match, so hot keys settle near
+	* the root and their lookups cost about the entropy of the traffic;
+	* equally used keys are ordered by a hash of their node's address, which
+	* keeps the expected depth O(log n) for any insertion order
+	* (const lookups leave the counts alone and descend like red_black);
+	* since a non-const find writes to the tree, concurrent readers must go
+	* through a const reference or be serialized like writers; split, join,
+	* the set operations and copies keep the counts and the heap order, while
+	* assign starts every element afresh
+	*/
+	struct frequency_weighted {};
+
+	/**
+	* tag asserting that a range is sorted under the tree's comparator
+	* and holds no equivalent elements, so it can be linked without checks
+	*/
+	struct sorted_unique_t { explicit sorted_unique_t() = default; };
+	inline constexpr sorted_unique_t sorted_unique{};
+
+	/**
+	* optional node augmentations and behaviours, combined with |
+	*/
+	enum bst_options : unsigned {
+		no_options = 0,
+		order_statistics = 1, // subtree sizes: nth, rank, iterator += in O(log n)
+		statistics = 2, // operation counters: stats() and reset_stats()
+		threaded = 4 // in-order prev/next links: iterator ++ and -- in one load
+	};
+
+	constexpr bst_options operator|(bst_options left, bst_options right) {
+		return static_cast<bst_options>(static_cast<unsigned>(left) | static_cast<unsigned>(right));
+	}
+
+	/**
+	* snapshot of the counters of a tree built with the statistics option
+	*/
+	struct bst_stats {
+
+		size_t comparisons = 0; // comparator calls
+		size_t allocations = 0; // nodes allocated
+		size_t frees = 0; // nodes freed (nodes extracted into handles are freed by the handle)
+		size_t rotations = 0; // rebalancing rotations
+		size_t iterator_steps = 0; // links followed by iterator ++ and --
+		size_t size = 0; // elements when the snapshot was taken
+		size_t height = 0; // nodes on the longest root-to-leaf path at that time
+
+		// descents (searches and insert positions) by number of nodes visited;
+		// the last bucket also holds every longer descent
+		std::array<size_t, 64> probe_lengths{};
+
+		/**
+		* number of descents recorded
+		* @return sum of probe_lengths
+		*/
+		size_t probes() const {
+
+			size_t total = 0;
+			for (size_t c : probe_lengths) {
+				total = total + c;
+			}
+			return total;
+		}
+
+		/**
+		* average number of nodes a descent visited
+		* @return mean probe length (0 if none were recorded)
+		*/
+		double mean_probe() const {
+
+			size_t total = 0; // nodes visited over all descents
+			for (size_t i = 0; i < probe_lengths.size(); ++i) {
+				total = total + i * probe_lengths[i];
+			}
+			size_t n = probes();
+			return n ? static_cast<double>(total) / static_cast<double>(n) : 0.0;
+		}
+
+		/**
+		* whether the height has drifted beyond c * log2(size + 1), for
+		* alerting (red-black trees stay within c = 2)
+		* @param c allowed factor over the minimum height
+		* @return whether height exceeds the bound
+		*/
+		bool height_exceeds(double c) const {
+			return static_cast<double>(height) > c * std::log2(static_cast<double>(size) + 1.0);
+		}
+	};
+
+	template <typename K, typename V, typename compare_type, typename balance_type, typename alloc_type>
+	class bst_map; // key-value map built on bst nodes (bst_map.h)
+
 	/**
 	* templated binary search tree class
 	* @param T the data type of binary search tree
 	* @param compare_type the comparison function to compare the data
+	* @param balance_type the balancing policy (red_black, unbalanced or frequency_weighted)
+	* @param alloc_type the allocator, rebound internally to the node type
+	* @param options optional augmentations (see bst_options)
 	*/
-	template <typename T, typename compare_type = std::less<T>>
-	class bst {
+	template <typename T, typename compare_type = std::less<T>, typename balance_type = red_black,
+		typename alloc_type = std::allocator<T>, bst_options options = no_options>
+	class bst : private detail::tree_counters<(options & statistics) != 0> {
 
 	public:
 
 		/**
-		* constructor which initializes: pred, root, and tree_size
+		* constructor which initializes: pred, root, tree_size, and alloc
+		* @param pred_input the comparison function to compare the data
+		* @param alloc_input the allocator used for the nodes
+		*/
+		bst(const compare_type& pred_input = compare_type(),
+			const alloc_type& alloc_input = alloc_type()) :
+			pred(pred_input), root(nullptr), tree_size(0), alloc(alloc_input) {}
+
+		/**
+		* constructor which initializes: pred, root, tree_size, and alloc
+		* @param alloc_input the allocator used for the nodes
+		*/
+		explicit bst(const alloc_type& alloc_input) :
+			bst(compare_type(), alloc_input) {}
+
+		/**
+		* range constructor which builds a balanced tree in O(n) if the
+		* range is already sorted, otherwise sorts a copy first
+		* @param first beginning of the range
+		* @param last end of the range
+		* @param pred_input the comparison function to compare the data
+		* @param alloc_input the allocator used for the nodes
+		*/
+		template <typename InputIt, typename = typename std::iterator_traits<InputIt>::iterator_category>
+		bst(InputIt first, InputIt last, const compare_type& pred_input = compare_type(),
+			const alloc_type& alloc_input = alloc_type()) :
+			bst(pred_input, alloc_input) { assign(first, last); }
+
+		/**
+		* range constructor which builds a balanced tree in O(n) from a
+		* range the caller guarantees sorted and free of equivalents
+		* @param first beginning of the range
+		* @param last end of the range
 		* @param pred_input the comparison function to compare the data
+		* @param alloc_input the allocator used for the nodes
 		*/
-		bst(const compare_type& pred_input = compare_type()) :
-			pred(pred_input), root(nullptr), tree_size(0) {}
+		template <typename InputIt, typename = typename std::iterator_traits<InputIt>::iterator_category>
+		bst(sorted_unique_t, InputIt first, InputIt last, const compare_type& pred_input = compare_type(),
+			const alloc_type& alloc_input = alloc_type()) :
+			bst(pred_input, alloc_input) { assign(sorted_unique, first, last); }
 
 		/**
 		* iterator class declaration
@@ -30,9 +343,30 @@ namespace binarysearch {
 		class iterator;
 
 		/**
-		* destructor which passes the implicit root to deleteTree
+		* read-only iterators over the elements in descending order
+		*/
+		using reverse_iterator = std::reverse_iterator<iterator>;
+		using const_reverse_iterator = reverse_iterator;
+
+		/**
+		* node handle class declaration
 		*/
-		~bst() { deleteTree(root); }
+		class node_type;
+
+		/**
+		* result of inserting a node handle: where the element is, whether
+		* the handle's node was linked, and the handle back if it was not
+		*/
+		struct insert_return_type {
+			iterator position;
+			bool inserted;
+			node_type node;
+		};
+
+		/**
+		* destructor which removes every element through clear
+		*/
+		~bst() { clear(); }
 
 		/**
 		* copy constructor
@@ -59,6 +393,194 @@ namespace binarysearch {
 		*/
 		iterator find(const T& item) const;
 
+		/**
+		* checks if a tree contains a particular element; under the
+		* frequency_weighted policy a hit is counted and may lift the element,
+		* which modifies the tree, so concurrent calls race (use the const find)
+		* @param item the type T element to look for
+		* @return iterator to the element
+		*/
+		iterator find(const T& item);
+
+		/**
+		* checks if a tree contains an element equivalent to key, without
+		* constructing a T (only with a transparent comparator)
+		* @param key value comparable with T through compare_type
+		* @return iterator to the element
+		*/
+		template <typename K, typename C = compare_type,
+			typename = std::enable_if_t<detail::is_transparent<C>::value>>
+		iterator find(const K& key) const;
+
+		/**
+		* checks if a tree contains an element equivalent to key, counting
+		* hits like find(const T&), so concurrent calls race under the
+		* frequency_weighted policy (only with a transparent comparator)
+		* @param key value comparable with T through compare_type
+		* @return iterator to the element
+		*/
+		template <typename K, typename C = compare_type,
+			typename = std::enable_if_t<detail::is_transparent<C>::value>>
+		iterator find(const K& key);
+
+		/**
+		* counts elements equivalent to a value
+		* @param item the type T element to look for
+		* @return 1 if present, 0 otherwise
+		*/
+		size_t count(const T& item) const;
+
+		/**
+		* counts elements equivalent to key (only with a transparent comparator)
+		* @param key value comparable with T through compare_type
+		* @return 1 if present, 0 otherwise
+		*/
+		template <typename K, typename C = compare_type,
+			typename = std::enable_if_t<detail::is_transparent<C>::value>>
+		size_t count(const K& key) const;
+
+		/**
+		* checks if a tree contains a particular element
+		* @param item the type T element to look for
+		* @return whether an equivalent element is present
+		*/
+		bool contains(const T& item) const;
+
+		/**
+		* checks if a tree contains an element equivalent to key
+		* (only with a transparent comparator)
+		* @param key value comparable with T through compare_type
+		* @return whether an equivalent element is present
+		*/
+		template <typename K, typename C = compare_type,
+			typename = std::enable_if_t<detail::is_transparent<C>::value>>
+		bool contains(const K& key) const;
+
+		/**
+		* first element not less than a value
+		* @param item the type T bound
+		* @return iterator to that element, or end()
+		*/
+		iterator lower_bound(const T& item) const;
+
+		/**
+		* first element not less than key (only with a transparent comparator)
+		* @param key bound comparable with T through compare_type
+		* @return iterator to that element, or end()
+		*/
+		template <typename K, typename C = compare_type,
+			typename = std::enable_if_t<detail::is_transparent<C>::value>>
+		iterator lower_bound(const K& key) const;
+
+		/**
+		* first element greater than a value
+		* @param item the type T bound
+		* @return iterator to that element, or end()
+		*/
+		iterator upper_bound(const T& item) const;
+
+		/**
+		* first element greater than key (only with a transparent comparator)
+		* @param key bound comparable with T through compare_type
+		* @return iterator to that element, or end()
+		*/
+		template <typename K, typename C = compare_type,
+			typename = std::enable_if_t<detail::is_transparent<C>::value>>
+		iterator upper_bound(const K& key) const;
+
+		/**
+		* range of elements equivalent to a value (at most one), in one descent
+		* @param item the type T element to look for
+		* @return lower_bound and upper_bound of item
+		*/
+		std::pair<iterator, iterator> equal_range(const T& item) const;
+
+		/**
+		* range of elements equivalent to key (only with a transparent comparator)
+		* @param key value comparable with T through compare_type
+		* @return lower_bound and upper_bound of key
+		*/
+		template <typename K, typename C = compare_type,
+			typename = std::enable_if_t<detail::is_transparent<C>::value>>
+		std::pair<iterator, iterator> equal_range(const K& key) const;
+
+		/**
+		* calls visit on every element in [low, high) in order, in
+		* O(height + k): only subtrees overlapping the range are entered
+		* @param low inclusive lower bound
+		* @param high exclusive upper bound
+		* @param visit callable taking const T&
+		*/
+		template <typename F>
+		void visit_range(const T& low, const T& high, F visit) const;
+
+		/**
+		* calls visit on every element in [low, high) in order
+		* (only with a transparent comparator)
+		* @param low inclusive lower bound comparable with T
+		* @param high exclusive upper bound comparable with T
+		* @param visit callable taking const T&
+		*/
+		template <typename K, typename F, typename C = compare_type,
+			typename = std::enable_if_t<detail::is_transparent<C>::value>>
+		void visit_range(const K& low, const K& high, F visit) const;
+
+		/**
+		* looks up a batch of keys, writing one iterator per key (end() if
+		* absent) in input order; the descents of up to 16 keys are
+		* interleaved with prefetching so their cache misses overlap
+		* @param first beginning of the keys (T, or K with a transparent comparator)
+		* @param last end of the keys
+		* @param out output iterator receiving iterators
+		* @return out advanced past the last result
+		*/
+		template <typename ForwardIt, typename OutputIt>
+		OutputIt find_many(ForwardIt first, ForwardIt last, OutputIt out) const;
+
+		/**
+		* counts elements in [low, high)
+		* @param low inclusive lower bound
+		* @param high exclusive upper bound
+		* @return number of elements in the range
+		*/
+		size_t count_range(const T& low, const T& high) const;
+
+		/**
+		* counts elements in [low, high) (only with a transparent comparator)
+		* @param low inclusive lower bound comparable with T
+		* @param high exclusive upper bound comparable with T
+		* @return number of elements in the range
+		*/
+		template <typename K, typename C = compare_type,
+			typename = std::enable_if_t<detail::is_transparent<C>::value>>
+		size_t count_range(const K& low, const K& high) const;
+
+		/**
+		* element at a position in sorted order, in O(log n)
+		* (requires order_statistics)
+		* @param k zero-based position
+		* @return iterator to the k-th smallest element, or end() if k >= size()
+		*/
+		iterator nth(size_t k) const;
+
+		/**
+		* number of elements less than a value, in O(log n)
+		* (requires order_statistics)
+		* @param item the type T bound
+		* @return position lower_bound(item) would have
+		*/
+		size_t rank(const T& item) const;
+
+		/**
+		* number of elements less than key (requires order_statistics
+		* and a transparent comparator)
+		* @param key bound comparable with T through compare_type
+		* @return position lower_bound(key) would have
+		*/
+		template <typename K, typename C = compare_type,
+			typename = std::enable_if_t<detail::is_transparent<C>::value>>
+		size_t rank(const K& key) const;
+
 		/**
 		* swaps two trees
 		* @param other tree to swap the implicit "this" tree with
@@ -77,17 +599,33 @@ namespace binarysearch {
 		*/
 		iterator end() const;
 
+		/**
+		* iterator to the largest element
+		* @return reverse iterator to rbegin position
+		*/
+		reverse_iterator rbegin() const;
+
+		/**
+		* iterator before the smallest element
+		* @return reverse iterator to rend position
+		*/
+		reverse_iterator rend() const;
+
 		/**
 		* adds given lvalue to the tree
 		* @param value the element to be added
+		* @return iterator to the element with an equivalent value and
+		* whether value was inserted (false if it was already present)
 		*/
-		void insert(const T& value);
+		std::pair<iterator, bool> insert(const T& value);
 
 		/**
 		* adds given rvalue to the tree
 		* @param value the element to be added
+		* @return iterator to the element with an equivalent value and
+		* whether value was inserted (false if it was already present)
 		*/
-		void insert(T&& value);
+		std::pair<iterator, bool> insert(T&& value);
 
 		/**
 		* removes given value from the tree
@@ -95,13 +633,93 @@ namespace binarysearch {
 		*/
 		void erase(iterator bad);
 
+		/**
+		* unlinks an element without destroying or moving it
+		* @param pos iterator to the element
+		* @return handle owning the element's node
+		*/
+		node_type extract(iterator pos);
+
+		/**
+		* unlinks the element equivalent to a value, if any
+		* @param item the type T element to look for
+		* @return handle owning the element's node (empty if absent)
+		*/
+		node_type extract(const T& item);
+
+		/**
+		* links the node of a handle in O(log n) without allocating or moving
+		* its element (a handle from a tree with an unequal allocator has its
+		* element moved into a new node instead)
+		* @param handle handle to take the node from
+		* @return position of the element with an equivalent value, whether the
+		* node was inserted, and the handle (still owning it) if it was not
+		*/
+		insert_return_type insert(node_type&& handle);
+
+		/**
+		* relinks every element of source that has no equivalent here, in
+		* O(m log(n + m)) without allocating or moving elements; the others
+		* stay in source (with unequal allocators the elements are moved
+		* into new nodes instead)
+		* @param source tree to take the elements from
+		*/
+		void merge(bst& source);
+
+		/**
+		* removes the element equivalent to a value, if any
+		* @param item the type T element to remove
+		* @return number of elements removed (0 or 1)
+		*/
+		size_t erase(const T& item);
+
+		/**
+		* removes the element equivalent to key, if any
+		* (only with a transparent comparator)
+		* @param key value comparable with T through compare_type
+		* @return number of elements removed (0 or 1)
+		*/
+		template <typename K, typename C = compare_type, typename = std::enable_if_t<
+			detail::is_transparent<C>::value && !std::is_convertible<K, iterator>::value>>
+		size_t erase(const K& key);
+
 		/**
 		* templated variadic function to construct T and
-		* attempt to place it within the tree
+		* attempt to place it within the tree; T is constructed once, in
+		* its node, and destroyed again if an equivalent is present
+		* @param args variadic list of arguments used to construct T
+		* @return iterator to the element with an equivalent value and
+		* whether the new element was inserted
+		*/
+		template <typename... Types>
+		std::pair<iterator, bool> emplace(Types&&... args);
+
+		/**
+		* like emplace, but tries the position next to hint first: when the
+		* new element belongs just before or just after hint, it is linked
+		* with at most two comparisons; finding hint's neighbours (or the last
+		* element for end()) still walks O(height) nodes, so elements arriving
+		* in order cost O(log n) each under red_black, O(height) otherwise
+		* @param hint iterator near where the element belongs
 		* @param args variadic list of arguments used to construct T
+		* @return iterator to the element with an equivalent value
 		*/
 		template <typename... Types>
-		void emplace(Types&&... args);
+		iterator emplace_hint(iterator hint, Types&&... args);
+
+		/**
+		* searches for key first and constructs T(key, args...) directly in
+		* a new node only if nothing equivalent is present, so a duplicate
+		* costs neither an allocation nor a construction; the constructed
+		* element must be equivalent to key (K other than T needs a
+		* transparent comparator)
+		* @param key value to search for, forwarded to T's constructor
+		* @param args further arguments forwarded to T's constructor
+		* @return iterator to the element with an equivalent value and
+		* whether the new element was inserted
+		*/
+		template <typename K, typename... Types>
+		std::pair<iterator, bool> try_emplace(K&& key, Types&&... args);
 
 		/**
 		* accessor to tree_size
@@ -109,591 +727,3245 @@ namespace binarysearch {
 		*/
 		size_t size() const;
 
-	private:
-		class node; // nested node class
-		node* root; // root node of the bst
-		compare_type pred; // comparison function to compare the data
-		size_t tree_size; // number of elements in the bst
-		void deleteTree(node*); // recursively delete elements of tree
-		void traverseInsert(node*); // help with copying
-	};
+		/**
+		* removes every element, keeping the comparator and allocator;
+		* with trivially destructible T and an unshared pool_allocator the
+		* whole pool is dropped at once without visiting the nodes
+		*/
+		void clear();
 
-	//nested iterator class definition
-	template <typename T, typename compare_type>
-	class bst<T, compare_type>::iterator { //nested iterator class
-		
-		friend bst; //to allow iterator modifications by bst operations
-	
-	public:
+		/**
+		* replaces the contents with a range; sorted, duplicate-free ranges
+		* are detected and linked in O(n), anything else is sorted first
+		* (of equivalent elements the first one is kept, as with insert)
+		* @param first beginning of the range
+		* @param last end of the range
+		*/
+		template <typename InputIt>
+		void assign(InputIt first, InputIt last);
 
 		/**
-		* overloaded prefix ++
+		* replaces the contents with a range the caller guarantees sorted
+		* and free of equivalents, building a balanced tree in O(n)
+		* @param first beginning of the range
+		* @param last end of the range
 		*/
-		iterator& operator++() {
+		template <typename InputIt>
+		void assign(sorted_unique_t, InputIt first, InputIt last);
 
-			if (curr->right) { // current node has right child
-				
-				curr = curr->right; // move to right child
-				
-				while (curr->left) { // current node has left child
+		/**
+		* moves the elements not less than key into a new tree in O(log n)
+		* under red_black and O(height) otherwise, without recursion (counting
+		* the two sizes takes O(min(k, n - k)) more without order_statistics);
+		* iterators stay valid and follow their element
+		* @param key the type T bound
+		* @return tree of the elements not less than key, sharing the allocator
+		*/
+		bst split(const T& key);
 
-					curr = curr->left; // move to left child
-				}
-			}
-			else { // current node does not have right child
-				
-				auto p = curr->parent; // current node's parent
-				
-				// current node exists and is parent's right child
-				while (p && (curr == p->right)) {
+		/**
+		* moves every element of greater to the end of this tree in O(log n)
+		* under red_black and O(height) otherwise, without recursion; each of
+		* them must be greater than every element of this tree
+		* (with unequal allocators the elements are copied one by one instead)
+		* @param greater tree to take the elements from, left empty
+		*/
+		void join(bst& greater);
 
-					curr = p; // move to parent node
-					p = p->parent; // update parent
-				}
-				
-				// move to parent node
-				// if previously at farthest right node, nullptr specifies end
-				curr = p;
-			}
-			return *this;
+		/**
+		* moves every element of other into this tree, destroying those already
+		* present; under red_black by divide and conquer on split and join, in
+		* O(m log(n / m + 1)) work for sizes m <= n with the top levels of the
+		* recursion on separate threads, and otherwise, where the recursion could
+		* be as deep as a degenerate tree, by relinking other's nodes one by one
+		* in O(m height) on one thread
+		* (with unequal allocators the elements are copied one by one instead);
+		* like split and join it relinks nodes in place, so compare_type must not
+		* throw, and with threads other than 1 it must be safe to call from
+		* several threads at once
+		* @param other tree to take the elements from, left empty
+		* @param threads threads to use (0 for one per core)
+		*/
+		void union_with(bst& other, unsigned threads = 0);
+
+		/**
+		* keeps only the elements equivalent to an element of other, in
+		* O(m log(n / m + 1)) work under red_black with the top levels on
+		* separate threads (so compare_type must then be safe to call from
+		* several threads at once), and otherwise in one merge walk of both
+		* trees in O(n + m) on one thread
+		* @param other tree to intersect with, unchanged
+		* @param threads threads to use (0 for one per core)
+		*/
+		void intersect(const bst& other, unsigned threads = 0);
+
+		/**
+		* removes the elements equivalent to an element of other, in
+		* O(m log(n / m + 1)) work under red_black with the top levels on
+		* separate threads (so compare_type must then be safe to call from
+		* several threads at once), and otherwise in one merge walk of both
+		* trees in O(n + m) on one thread
+		* @param other tree of elements to remove, unchanged
+		* @param threads threads to use (0 for one per core)
+		*/
+		void difference(const bst& other, unsigned threads = 0);
+
+		/**
+		* calls f on every element, splitting the top levels of the tree across
+		* threads: each subtree is visited in order, but subtrees run concurrently,
+		* so f must be safe to call from several threads at once
+		* @param f callable taking const T&
+		* @param threads threads to use (0 for one per core)
+		*/
+		template <typename F>
+		void parallel_for_each(F f, unsigned threads = 0) const;
+
+		/**
+		* folds the elements in order as combine(... combine(identity, map(first)) ...,
+		* map(last)), evaluating subtrees on separate threads; combine must be
+		* associative with identity as its neutral element
+		* @param identity neutral element of combine
+		* @param map callable from const T& to R, safe to call concurrently
+		* @param combine associative callable from (R, R) to R, likewise
+		* @param threads threads to use (0 for one per core)
+		* @return the folded value (identity if the tree is empty)
+		*/
+		template <typename R, typename Map, typename Combine>
+		R parallel_reduce(R identity, Map map, Combine combine, unsigned threads = 0) const;
+
+		/**
+		* number of nodes on the longest root-to-leaf path
+		* @return height of the tree (0 if empty)
+		*/
+		size_t height() const;
+
+		/**
+		* accessor to a copy of the allocator
+		* @return the allocator, rebound to T
+		*/
+		alloc_type get_allocator() const;
+
+		/**
+		* accessor to a copy of the comparison function
+		* @return pred
+		*/
+		compare_type key_comp() const;
+
+		/**
+		* snapshot of the operation counters (requires statistics); the
+		* height is measured now, in O(n)
+		* @return counts since construction or the last reset_stats()
+		*/
+		bst_stats stats() const;
+
+		/**
+		* zeroes the operation counters (requires statistics)
+		*/
+		void reset_stats();
+
+	private:
+		class node; // nested node class
+
+		// maps search with a bare key and construct entries in place
+		template <typename, typename, typename, typename, typename>
+		friend class bst_map;
+
+		// allocator rebound to nodes, and its traits
+		using node_alloc_type = typename std::allocator_traits<alloc_type>::template rebind_alloc<node>;
+		using node_traits = std::allocator_traits<node_alloc_type>;
+
+		compare_type pred; // comparison function to compare the data
+		node* root; // root node of the bst
+		size_t tree_size; // number of elements in the bst
+		node_alloc_type alloc; // allocator for the nodes
+
+		template <typename... Types>
+		node* createNode(Types&&...); // allocate and construct a node
+		void destroyNode(node*); // destroy and deallocate a node
+		bool releaseNodes(); // free all nodes at once if the allocator allows
+		size_t deleteTree(node*); // iteratively delete a subtree, counting its nodes
+		node* cloneTree(const node*); // help with copying
+		static void copyAugment(node*, const node*); // copy color, subtree size and weight
+
+		// link the next n elements of a sorted range into a balanced subtree
+		template <typename It>
+		node* buildTree(It&, size_t, size_t, size_t);
+
+		// locate where key belongs: equivalent node, or null with parent/side set
+		template <typename K>
+		node* insertPosition(const K&, node*&, bool&) const;
+
+		void linkNode(node*, node*, bool); // hang new node from parent and rebalance
+		void unlinkNode(node*); // take a node out of the tree and rebalance, keeping it
+		static void resetNode(node*); // clear a detached node's links and augmentation
+
+		// node equivalent to key, or null
+		template <typename K>
+		node* findNode(const K&) const;
+
+		// node equivalent to key, or null, stopping at the match; a hit
+		// is counted and lifts the node past parents used less often
+		template <typename K>
+		node* accessNode(const K&);
+
+		// first node not less than key, or null
+		template <typename K>
+		node* lowerBoundNode(const K&) const;
+
+		// first node greater than key, or null
+		template <typename K>
+		node* upperBoundNode(const K&) const;
+
+		// in-order successor of a node, or null
+		static node* nextNode(node*);
+
+		// in-order predecessor of a node, or null
+		static node* prevNode(node*);
+
+		// where value belongs if it sits right next to hint (null for end()):
+		// false if the hint does not help, else parent/side set as by insertPosition
+		bool hintPosition(node*, const T&, node*&, bool&) const;
+
+		// link a constructed node unless an equivalent is present, then destroy it
+		std::pair<iterator, bool> linkOrDestroy(node*, node*, node*, bool);
+
+		// search with key and construct a node from args only on a miss
+		template <typename K, typename... Types>
+		std::pair<iterator, bool> emplaceKey(const K&, Types&&...);
+
+		// call visit on the nodes from lowerBoundNode(low) up to high
+		template <typename K, typename F>
+		void visitNodes(const K&, const K&, F&) const;
+
+		// number of nodes in [low, high)
+		template <typename K>
+		size_t countNodes(const K&, const K&) const;
+
+		// whether insert and erase restore the red-black properties
+		static constexpr bool balanced = std::is_same<balance_type, red_black>::value;
+
+		// whether nodes are heap-ordered by access counts
+		static constexpr bool weighted = std::is_same<balance_type, frequency_weighted>::value;
+
+		// whether nodes link to their in-order neighbours
+		static constexpr bool linked = (options & threaded) != 0;
+
+		void threadNodes(); // relink every node's prev and next by an in-order walk, O(n)
+
+		// whether nodes carry subtree sizes
+		static constexpr bool ranked = (options & order_statistics) != 0;
+
+		// whether operations are counted for stats()
+		static constexpr bool counted = (options & statistics) != 0;
+
+		// pred(a, b), counted under the statistics option
+		template <typename A, typename B>
+		bool precedes(const A& a, const B& b) const {
+			this->countComparison();
+			return pred(a, b);
 		}
 
+		static size_t countOf(const node*); // subtree size (0 for null)
+		void recount(node*); // recompute subtree size from children
+		size_t position(const node*) const; // zero-based rank of a node
+		template <typename K>
+		size_t rankOf(const K&) const; // number of elements less than key
+
+		// detached red-black tree for split and join: a black root (or null)
+		// and its black height, the number of black nodes on each path down
+		struct part {
+			node* root;
+			size_t black;
+		};
+
+		// nodes dropped by a set operation, chained through their parent links;
+		// each is the root of a detached subtree, freed once the threads are done
+		struct discard_list {
+			node* head = nullptr;
+			node* tail = nullptr;
+		};
+
+		part whole() const; // the tree as a part (the root stays linked to it)
+		static part detach(node*, const part&); // cut a child of a part's root loose
+		part joinParts(part, node*, part); // left part, node, right part joined
+		part joinParts(part, part); // left part and right part joined
+
+		// part split into the elements before key, the one equivalent, and after
+		template <typename K>
+		void splitParts(part, const K&, part&, node*&, part&);
+
+		void splitLast(part, part&, node*&); // largest node split off a nonempty part
+		part unionParts(part, part, unsigned, discard_list&); // consumes both parts
+		part intersectParts(part, const node*, unsigned, discard_list&); // keeps what the subtree holds
+		part differenceParts(part, const node*, unsigned, discard_list&); // drops what the subtree holds
+
+		// split and join without red-black heights bound no recursion depth, so
+		// unbalanced and frequency_weighted trees use these loops instead
+		void splitChain(const T&, node*&, node*&); // the tree cut along one path into before and from key
+		node* joinChains(node*, node*); // two trees zipped along their facing spines
+		void filterNodes(const bst&, bool); // erase what other holds (or lacks) in one merge walk
+		static void discard(discard_list&, node*); // chain a detached subtree for freeing
+		static void append(discard_list&, discard_list&); // move one chain onto another
+		size_t freeDiscards(discard_list&); // free every chained subtree, counting nodes
+		bool sharesAllocator(const bst&) const; // whether other's nodes can be linked here
+		static unsigned forkLevels(unsigned, size_t); // recursion levels that fork a thread
+		static size_t countFirst(node*, node*, size_t); // size of the first of two parts totalling n
+
+		// call f on every element of a subtree, forking the top levels
+		template <typename F>
+		void forEachNodes(node*, F&, unsigned) const;
+
+		// fold a subtree in order, forking the top levels
+		template <typename R, typename Map, typename Combine>
+		R reduceNodes(node*, const R&, Map&, Combine&, unsigned) const;
+
+		// call f on every element of a subtree in order, without recursion
+		template <typename F>
+		static void walkSubtree(node*, F&);
+
+		// the tree-shaping helpers below take the root of the tree they work on,
+		// which is the member root except for detached trees in split and join
+		static bool isRed(const node*); // null children count as black
+		void rotateLeft(node*, node*&); // lift right child of node into its place
+		void rotateRight(node*, node*&); // lift left child of node into its place
+		void riseNode(node*); // rotate a node up past parents of lower weight
+		void sinkNode(node*); // rotate a node down until it has at most one child
+		void siftNode(node*, node*&); // rotate a node down below every heavier child
+		void heapNodes(node*); // restore heap order in a subtree, children first
+		void transplant(node*, node*, node*&); // replace subtree in its parent
+		bool insertFixup(node*, node*&); // restore red-black properties after insert
+		void eraseFixup(node*, node*); // restore red-black properties after erase
+	};
+
+	//nested iterator class definition
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	class bst<T, compare_type, balance_type, alloc_type, options>::iterator { //nested iterator class
+		
+		friend bst; //to allow iterator modifications by bst operations
+	
+		public:
+
+		// standard iterator traits (bidirectional, read-only)
+		using iterator_category = std::bidirectional_iterator_tag;
+		using value_type = T;
+		using difference_type = std::ptrdiff_t;
+		using pointer = const T*;
+		using reference = const T&;
+
 		/**
-		* overloaded postfix ++
+		* default constructor, a singular iterator that may only be assigned
+		* to or compared with other default-constructed iterators
 		*/
-		iterator operator++(int) {
-			
-			auto copy(*this); // copy of current node
+		iterator() : curr(nullptr), container(nullptr) {}
+
+		/**
+		* overloaded prefix ++
+		*/
+		iterator& operator++() {
+
+			if constexpr (linked) { // one load
+
+				curr = curr->next;
+				container->countStep();
+				return *this;
+			}
 
 			if (curr->right) { // current node has right child
 				
 				curr = curr->right; // move to right child
+				container->countStep();
 				
 				while (curr->left) { // current node has left child
 
 					curr = curr->left; // move to left child
+					container->countStep();
 				}
 			}
-			else { // current node does not have right
-
+			else { // current node does not have right child
+				
 				auto p = curr->parent; // current node's parent
-
-				// current node is parent's right child
+				container->countStep();
+				
+				// current node exists and is parent's right child
 				while (p && (curr == p->right)) {
 
 					curr = p; // move to parent node
 					p = p->parent; // update parent
+					container->countStep();
 				}
 				
 				// move to parent node
 				// if previously at farthest right node, nullptr specifies end
 				curr = p;
 			}
+			return *this;
+		}
+
+		/**
+		* overloaded postfix ++
+		*/
+		iterator operator++(int) {
+			
+			auto copy(*this); // copy of current node
+			++*this;
 			return copy;
 		}
 
 		/**
-		* overloaded prefix --
+		* overloaded prefix --; decrementing end() gives the largest element,
+		* and decrementing begin() gives end()
 		*/
 		iterator& operator--() {
+
+			if (!curr) { // past-the-end: descend to the largest element
+
+				for (curr = container->root; curr && curr->right; curr = curr->right) {
+					container->countStep();
+				}
+				return *this;
+			}
+
+			if constexpr (linked) { // one load
+
+				curr = curr->prev;
+				container->countStep();
+				return *this;
+			}
 			
 			if (curr->left) { // current node has left child
 				
 				curr = curr->left; // move to left child
+				container->countStep();
 				
 				while (curr->right) { // current node has right child
 
 					curr = curr->right; // move to right child
+					container->countStep();
 				}
 			}
 			else { // current node does not have left child
 				
 				auto p = curr->parent; // current node's parent
+				container->countStep();
 				
-				// current node is parent's left child
-				while (curr == p->left) {
+				// current node exists and is parent's left child
+				while (p && (curr == p->left)) {
 
 					curr = p; // move to parent node
 					p = p->parent; // update parent
+					container->countStep();
 				}
 				
-				curr = p; // current node is right child, move to parent
+				// move to parent node
+				// if previously at farthest left node, nullptr specifies end
+				curr = p;
 			}
 			return *this;
 		}
 
-		/**
-		* overloaded postfix --
-		*/
-		iterator operator--(int) {
-			
-			auto copy(*this); // copy of current node
-			
-			if (curr->left) { // current node has left child
+		/**
+		* overloaded postfix --
+		*/
+		iterator operator--(int) {
+			
+			auto copy(*this); // copy of current node
+			--*this;
+			return copy;
+		}
+
+		/**
+		* advances by k positions (negative moves back) in O(log n)
+		* (requires order_statistics); stepping past either end gives end()
+		* @param k number of positions to move
+		*/
+		iterator& operator+=(std::ptrdiff_t k) {
+
+			static_assert(ranked, "iterator += requires the order_statistics option");
+
+			// current position, then the node at the target position
+			std::ptrdiff_t target = static_cast<std::ptrdiff_t>(container->position(curr)) + k;
+			curr = target < 0 ? nullptr : container->nth(static_cast<size_t>(target)).curr;
+			return *this;
+		}
+
+		/**
+		* moves back by k positions in O(log n) (requires order_statistics)
+		* @param k number of positions to move
+		*/
+		iterator& operator-=(std::ptrdiff_t k) {
+			return *this += -k;
+		}
+
+		/**
+		* overloaded == comparison operator
+		*/
+		friend bool operator==(const iterator& left, const iterator& right) {
+			
+			/* whether left iterator's current node is
+			right iterator's current node */
+			return left.curr == right.curr;
+		}
+
+		/**
+		* overloaded != comparison operator
+		*/
+		friend bool operator!=(const iterator& left, const iterator& right) {
+
+			/* whether left iterator's current node is not
+			right iterator's current node */
+			return left.curr != right.curr;
+		}
+
+		/**
+		* overload dereferencing operator (without modifying tree element)
+		*/
+		const T& operator*() const {
+			return curr->value; // value contained by current node
+		}
+
+		/**
+		* overload the operator arrow (without modifying tree element)
+		*/
+		const T* operator->() const {
+			return &curr->value; // value contained by current node
+		}
+
+	private:
+
+		/**
+		* constructor which initializes curr and container
+		* @param n the current node
+		* @param c the tree container
+		*/
+		iterator(node* n, const bst* c) :
+			curr(n), container(c) {}
+
+		node* curr; //current position
+		const bst* container; // holding container
+	};
+
+	//nested node handle class definition
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	class bst<T, compare_type, balance_type, alloc_type, options>::node_type { //nested node handle class
+
+		friend bst; //to allow handle construction and release by bst operations
+
+		public:
+
+		using value_type = T;
+		using allocator_type = alloc_type;
+
+		/**
+		* constructor which initializes an empty handle
+		*/
+		node_type() : held(nullptr) {}
+
+		/**
+		* move constructor
+		* @param that rvalue reference to move-from handle, left empty
+		*/
+		node_type(node_type&& that) noexcept : held(that.held), alloc(std::move(that.alloc)) {
+			that.held = nullptr;
+			that.alloc.reset();
+		}
+
+		/**
+		* move assignment operator, destroying the element held before
+		* @param that rvalue reference to move-from handle, left empty
+		*/
+		node_type& operator=(node_type&& that) noexcept {
+
+			node_type old(std::move(*this)); // destroyed on return
+			swap(that);
+			return *this;
+		}
+
+		node_type(const node_type&) = delete;
+		node_type& operator=(const node_type&) = delete;
+
+		/**
+		* destructor which destroys the element, if any, and frees its node
+		*/
+		~node_type() {
+			if (held) {
+				node_traits::destroy(*alloc, held);
+				node_traits::deallocate(*alloc, held, 1);
+			}
+		}
+
+		/**
+		* checks if the handle owns no node
+		* @return whether the handle is empty
+		*/
+		bool empty() const { return !held; }
+
+		/**
+		* checks if the handle owns a node
+		*/
+		explicit operator bool() const { return held != nullptr; }
+
+		/**
+		* accessor to the element; it may be modified before reinsertion
+		* @return the element in the node (the handle must not be empty)
+		*/
+		T& value() const { return held->value; }
+
+		/**
+		* accessor to a copy of the allocator the node came from
+		* @return the allocator, rebound to T (the handle must not be empty)
+		*/
+		alloc_type get_allocator() const { return alloc_type(*alloc); }
+
+		/**
+		* swaps two handles
+		* @param other handle to swap the implicit "this" handle with
+		*/
+		void swap(node_type& other) noexcept {
+			std::swap(held, other.held);
+			std::swap(alloc, other.alloc);
+		}
+
+	private:
+
+		/**
+		* constructor which takes over an unlinked node
+		* @param n the node, allocated by a
+		* @param a the allocator that frees it
+		*/
+		node_type(node* n, const node_alloc_type& a) : held(n), alloc(a) {}
+
+		node* held; // owned, unlinked node (null if empty)
+		std::optional<node_alloc_type> alloc; // allocator that frees it
+	};
+
+	// delete every node of the subtree rooted at n
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	size_t bst<T, compare_type, balance_type, alloc_type, options>::deleteTree(node* n) {
+
+		if (!n) { // nothing to delete
+			return 0;
+		}
+
+		node* stop = n->parent; // walk ends when we climb above n
+		size_t deleted = 0; // nodes deleted so far
+
+		// post-order walk through parent links: no stack, no recursion
+		while (n != stop) {
+
+			if (n->left) { // descend into left subtree first
+				n = n->left;
+			}
+			else if (n->right) { // then into right subtree
+				n = n->right;
+			}
+			else { // leaf: unhook it from its parent and delete it
+
+				node* p = n->parent;
+
+				if (p && p->left == n) { // node is left child
+					p->left = nullptr;
+				}
+				else if (p) { // node is right child
+					p->right = nullptr;
+				}
+
+				destroyNode(n); // delete node
+				deleted = deleted + 1;
+				n = p; // continue from parent
+			}
+		}
+
+		return deleted;
+	}
+
+	// removes every element from the tree
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	void bst<T, compare_type, balance_type, alloc_type, options>::clear() {
+
+		if (!releaseNodes()) { // pool could not be dropped at once
+			deleteTree(root);
+		}
+
+		root = nullptr;
+		tree_size = 0;
+	}
+
+	// allocate a node and construct it from args
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	template <typename... Types>
+	typename bst<T, compare_type, balance_type, alloc_type, options>::node*
+		bst<T, compare_type, balance_type, alloc_type, options>::createNode(Types&&... args) {
+
+		node* n = node_traits::allocate(alloc, 1); // uninitialized node
+
+		try {
+			node_traits::construct(alloc, n, std::forward<Types>(args)...);
+		}
+		catch (...) { // T's constructor threw, give the memory back
+			node_traits::deallocate(alloc, n, 1);
+			throw;
+		}
+
+		this->countAllocation();
+		return n;
+	}
+
+	// destroy a node and return its memory
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	void bst<T, compare_type, balance_type, alloc_type, options>::destroyNode(node* n) {
+
+		node_traits::destroy(alloc, n);
+		node_traits::deallocate(alloc, n, 1);
+		this->countFrees(1);
+	}
+
+	// free all nodes at once when no destructor has to run
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	bool bst<T, compare_type, balance_type, alloc_type, options>::releaseNodes() {
+
+		if constexpr (detail::has_release<node_alloc_type>::value
+			&& std::is_trivially_destructible<T>::value) {
+
+			if (alloc.release()) { // pool not shared: O(slabs)
+
+				this->countFrees(tree_size);
+				root = nullptr;
+				tree_size = 0;
+				return true;
+			}
+		}
+
+		return false; // nodes must be destroyed one by one
+	}
+
+	// clone the subtree rooted at src without comparisons
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	typename bst<T, compare_type, balance_type, alloc_type, options>::node*
+		bst<T, compare_type, balance_type, alloc_type, options>::cloneTree(const node* src) {
+
+		if (!src) { // nothing to clone
+			return nullptr;
+		}
+
+		node* top = createNode(src->value); // clone of src
+		copyAugment(top, src);
+
+		const node* s = src; // current source node
+		node* d = top; // its clone
+
+		try {
+
+			// pre-order walk through parent links, cloning each child once
+			while (true) {
+
+				if (s->left && !d->left) { // left child not cloned yet
+
+					s = s->left;
+					d->left = createNode(s->value);
+					d->left->parent = d;
+					d = d->left;
+					copyAugment(d, s);
+				}
+				else if (s->right && !d->right) { // right child not cloned yet
+
+					s = s->right;
+					d->right = createNode(s->value);
+					d->right->parent = d;
+					d = d->right;
+					copyAugment(d, s);
+				}
+				else if (s != src) { // both subtrees cloned, go back up
+
+					s = s->parent;
+					d = d->parent;
+				}
+				else { // back at the top, clone complete
+					break;
+				}
+			}
+		}
+		catch (...) { // T's copy threw, free the partial clone
+			deleteTree(top);
+			throw;
+		}
+
+		return top;
+	}
+
+	// replace the contents with a range, sorting it if needed
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	template <typename InputIt>
+	void bst<T, compare_type, balance_type, alloc_type, options>::assign(InputIt first, InputIt last) {
+
+		using category = typename std::iterator_traits<InputIt>::iterator_category;
+
+		// whether a precedes b strictly (sorted and unique)
+		auto strictly_before = [this](const T& a, const T& b) { return precedes(a, b); };
+
+		if constexpr (std::is_base_of<std::forward_iterator_tag, category>::value) {
+
+			// already sorted without equivalents: link directly
+			if (std::adjacent_find(first, last, std::not_fn(strictly_before)) == last) {
+				assign(sorted_unique, first, last);
+				return;
+			}
+		}
+
+		std::vector<T> buffer(first, last); // sortable copy of the range
+
+		// stable so the first of several equivalent elements survives
+		std::stable_sort(buffer.begin(), buffer.end(), strictly_before);
+
+		// drop all but the first of each run of equivalent elements
+		auto equivalent = [this](const T& a, const T& b) { return !precedes(a, b); };
+		buffer.erase(std::unique(buffer.begin(), buffer.end(), equivalent), buffer.end());
+
+		assign(sorted_unique, std::make_move_iterator(buffer.begin()),
+			std::make_move_iterator(buffer.end()));
+	}
+
+	// replace the contents with a sorted, duplicate-free range in O(n)
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	template <typename InputIt>
+	void bst<T, compare_type, balance_type, alloc_type, options>::assign(sorted_unique_t, InputIt first, InputIt last) {
+
+		using category = typename std::iterator_traits<InputIt>::iterator_category;
+
+		if constexpr (!std::is_base_of<std::forward_iterator_tag, category>::value) {
+
+			// single-pass range: buffer it so it can be counted
+			std::vector<T> buffer(first, last);
+			assign(sorted_unique, std::make_move_iterator(buffer.begin()),
+				std::make_move_iterator(buffer.end()));
+		}
+		else {
+
+			size_t n = static_cast<size_t>(std::distance(first, last)); // elements to link
+
+			size_t deepest = 0; // depth of the bottom level of the balanced tree
+			while ((size_t(2) << deepest) <= n) {
+				deepest = deepest + 1;
+			}
+
+			node* top = buildTree(first, n, 0, deepest); // throws before touching the tree
+
+			// drop the old contents one by one: releasing a pool at once
+			// would also free the nodes just built from it
+			deleteTree(root);
+			root = top;
+			tree_size = n;
+			threadNodes();
+
+			if constexpr (weighted) { // the balanced shape ignores the fresh nodes' weights
+				heapNodes(root);
+			}
+		}
+	}
+
+	// link the next n elements of a sorted range into a balanced subtree
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	template <typename It>
+	typename bst<T, compare_type, balance_type, alloc_type, options>::node*
+		bst<T, compare_type, balance_type, alloc_type, options>::buildTree(It& it, size_t n, size_t depth, size_t deepest) {
+
+		if (!n) { // empty subtree
+			return nullptr;
+		}
+
+		// halves differ by at most one, so only the bottom level is partial
+		size_t left_count = n / 2;
+
+		node* l = buildTree(it, left_count, depth + 1, deepest); // left half first, in order
+		node* m; // middle element
+
+		try {
+			m = createNode(*it);
+		}
+		catch (...) { // free the finished left half
+			deleteTree(l);
+			throw;
+		}
+
+		++it;
+		m->left = l;
+
+		if (l) { // left half exists
+			l->parent = m;
+		}
+
+		try {
+			m->right = buildTree(it, n - left_count - 1, depth + 1, deepest);
+		}
+		catch (...) { // free this subtree so far
+			deleteTree(m);
+			throw;
+		}
+
+		if (m->right) { // right half exists
+			m->right->parent = m;
+		}
+
+		// black everywhere except a red bottom level keeps black heights equal
+		m->red = depth == deepest && depth > 0;
+
+		if constexpr (ranked) { // subtree holds exactly n elements
+			m->count = n;
+		}
+
+		return m;
+	}
+
+	// copy color and subtree size from src to its clone
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	void bst<T, compare_type, balance_type, alloc_type, options>::copyAugment(node* clone, const node* src) {
+
+		clone->red = src->red;
+
+		if constexpr (ranked) {
+			clone->count = src->count;
+		}
+
+		if constexpr (weighted) { // the copy keeps the shape, so it keeps the heap order
+			clone->weight = src->weight;
+		}
+	}
+
+	// copy constructor
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	bst<T, compare_type, balance_type, alloc_type, options>::bst(const bst& rhs) : pred(rhs.pred), root(nullptr), tree_size(0),
+		alloc(node_traits::select_on_container_copy_construction(rhs.alloc)) {
+		
+		root = cloneTree(rhs.root); // duplicate the structure node for node
+		tree_size = rhs.tree_size;
+		threadNodes();
+	}
+
+	// move constructor
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	bst<T, compare_type, balance_type, alloc_type, options>::bst(bst&& that) noexcept :
+		pred(that.pred), root(nullptr), tree_size(0), alloc(std::move(that.alloc)) {
+		
+		// take the nodes; the moved-from tree keeps an allocator equal to ours
+		std::swap(this->root, that.root);
+		std::swap(this->tree_size, that.tree_size);
+	}
+
+	// copy/move assignment operator
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	bst<T, compare_type, balance_type, alloc_type, options>& bst<T, compare_type, balance_type, alloc_type, options>::operator=(bst that) & {
+		
+		(*this).swap(that); // swap implicit tree with given tree
+		return *this; // return implicit tree
+	}
+
+	// swap two Trees (member function)
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	void bst<T, compare_type, balance_type, alloc_type, options>::swap(bst& other) {
+		
+		// swap root of implicit tree with given tree
+		std::swap(this->root, other.root);
+
+		// swap predicate of implicit tree with given tree
+		std::swap(this->pred, other.pred);
+
+		// swap tree_size of implicit tree with given tree
+		std::swap(this->tree_size, other.tree_size);
+
+		// nodes follow their allocator if it propagates (otherwise they must be equal)
+		if constexpr (node_traits::propagate_on_container_swap::value) {
+			std::swap(this->alloc, other.alloc);
+		}
+	}
+
+	// swap two Trees (free function)
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	void swap(bst<T, compare_type, balance_type, alloc_type, options>& first, bst<T, compare_type, balance_type, alloc_type, options>& second) {
+
+		first.swap(second); // use member function to swap first tree with second
+	}
+
+	// iterator to begin position (farthest left node)
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	typename bst<T, compare_type, balance_type, alloc_type, options>::iterator bst<T, compare_type, balance_type, alloc_type, options>::begin() const {
+		
+		if (!root) { // root is null (tree is empty)
+
+			// return iterator to past-the-end position (nullptr)
+			return iterator(nullptr, this);
+		}
+		
+		node* n = root; // start at the root
+		
+		while (n->left) { // left child is not null
+			n = n->left; // go left
+		}
+		
+		return iterator(n, this); // iterator to node containing smallest value
+	}
+
+	// iterator to past-the-end position (nullptr)
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	typename bst<T, compare_type, balance_type, alloc_type, options>::iterator bst<T, compare_type, balance_type, alloc_type, options>::end() const {
+		return iterator(nullptr, this); // iterator to nullptr
+	}
+
+	// reverse iterator to the largest element
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	typename bst<T, compare_type, balance_type, alloc_type, options>::reverse_iterator bst<T, compare_type, balance_type, alloc_type, options>::rbegin() const {
+		return reverse_iterator(end()); // dereferences --end()
+	}
+
+	// reverse iterator before the smallest element
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	typename bst<T, compare_type, balance_type, alloc_type, options>::reverse_iterator bst<T, compare_type, balance_type, alloc_type, options>::rend() const {
+		return reverse_iterator(begin());
+	}
+
+	// to add a value to the tree (lvalue)
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	std::pair<typename bst<T, compare_type, balance_type, alloc_type, options>::iterator, bool>
+		bst<T, compare_type, balance_type, alloc_type, options>::insert(const T& val) {
+
+		node* parent; // node the new value hangs from
+		bool left; // whether it hangs as the left child
+
+		// existing node with an equivalent value
+		node* found = insertPosition(val, parent, left);
+
+		if (found) { // value already present, nothing allocated
+			return { iterator(found, this), false };
+		}
+
+		node* n = createNode(val); // create a new node
+		linkNode(n, parent, left); // hang it from its parent
+
+		return { iterator(n, this), true };
+	}
+
+	// to add a value to the tree (rvalue)
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	std::pair<typename bst<T, compare_type, balance_type, alloc_type, options>::iterator, bool>
+		bst<T, compare_type, balance_type, alloc_type, options>::insert(T&& val) {
+
+		node* parent; // node the new value hangs from
+		bool left; // whether it hangs as the left child
+
+		// existing node with an equivalent value
+		node* found = insertPosition(val, parent, left);
+
+		if (found) { // value already present, nothing allocated
+			return { iterator(found, this), false };
+		}
+
+		node* n = createNode(std::move(val)); // create a new node
+		linkNode(n, parent, left); // hang it from its parent
+
+		return { iterator(n, this), true };
+	}
+
+	// locate where a key belongs without modifying the tree
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	template <typename K>
+	typename bst<T, compare_type, balance_type, alloc_type, options>::node*
+		bst<T, compare_type, balance_type, alloc_type, options>::insertPosition(const K& key, node*& parent, bool& left) const {
+
+		node* n = root; // start at the root
+		node* candidate = nullptr; // last node key was not less than
+		parent = nullptr;
+		left = false;
+
+		size_t visited = 0; // probe length, for stats()
+
+		// one comparison per level: go left if key < value, else right
+		while (n) {
+
+			visited = visited + 1;
+			parent = n;
+			left = precedes(key, n->value);
+
+			if (left) { // key less than current node value
+				n = n->left; // move left
+			}
+			else { // key not less than current node value
+				candidate = n; // only possible equivalent so far
+				n = n->right; // move right
+			}
+		}
+
+		this->countProbe(visited);
+
+		// key is equivalent to candidate if candidate is not less than key
+		if (candidate && !precedes(candidate->value, key)) {
+			return candidate;
+		}
+
+		return nullptr; // key is not in the tree
+	}
+
+	// hang a new node from parent and rebalance
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	void bst<T, compare_type, balance_type, alloc_type, options>::linkNode(node* n, node* parent, bool left) {
+
+		n->parent = parent; // set parent for node
+
+		if (!parent) { // tree is empty
+			root = n;
+		}
+		else if (left) { // new left child
+			parent->left = n;
+		}
+		else { // new right child
+			parent->right = n;
+		}
+
+		if constexpr (linked) { // a left child comes just before its parent, a right child just after
+			n->prev = !parent ? nullptr : (left ? parent->prev : parent);
+			n->next = !parent ? nullptr : (left ? parent : parent->next);
+
+			if (n->prev) {
+				n->prev->next = n;
+			}
+			if (n->next) {
+				n->next->prev = n;
+			}
+		}
+
+		tree_size = tree_size + 1; // increment size of tree
+
+		if constexpr (ranked) { // every ancestor gained one node
+			for (node* p = parent; p; p = p->parent) {
+				p->count = p->count + 1;
+			}
+		}
+
+		insertFixup(n, root); // rebalance around the new node
+
+		if constexpr (weighted) { // restore heap order above the new leaf
+			riseNode(n);
+		}
+	}
+
+	// nested node class definition
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	class bst<T, compare_type, balance_type, alloc_type, options>::node :
+		public detail::subtree_size<(options & order_statistics) != 0>,
+		public detail::access_weight<std::is_same<balance_type, frequency_weighted>::value>,
+		public detail::order_links<(options & threaded) != 0, typename bst<T, compare_type, balance_type, alloc_type, options>::node> {
+		
+		friend bst; // tree member functions may search through nodes
+		friend iterator; // to be able to advance by checking node values
+	
+	public:
+
+		/**
+		* constructor which initializes left, right, parent, red, and value
+		* (public so the allocator can construct nodes; node itself is private)
+		* @param args arguments forwarded to T's constructor
+		*/
+		template <typename... Types>
+		explicit node(Types&&... args) : left(nullptr), right(nullptr), parent(nullptr),
+			red(true), value(std::forward<Types>(args)...) {}
+
+	private:
+
+		node* left; // left child node
+		node* right; // right child node
+		node* parent; // parent node
+		bool red; // red-black color (new nodes start red)
+
+		T value; // data value stored
+	};
+
+	// node equivalent to key, or null
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	template <typename K>
+	typename bst<T, compare_type, balance_type, alloc_type, options>::node*
+		bst<T, compare_type, balance_type, alloc_type, options>::findNode(const K& key) const {
+
+		node* candidate = lowerBoundNode(key); // first node not less than key
+
+		// key is equivalent to candidate if key is not less than candidate
+		if (candidate && !precedes(key, candidate->value)) {
+			return candidate;
+		}
+
+		return nullptr; // key is not in tree
+	}
+
+	// node equivalent to key, or null; a hit raises the node's weight
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	template <typename K>
+	typename bst<T, compare_type, balance_type, alloc_type, options>::node*
+		bst<T, compare_type, balance_type, alloc_type, options>::accessNode(const K& key) {
+
+		node* n = root; // start at the root
+		size_t visited = 0; // probe length, for stats()
+
+		// up to two comparisons per level, so a hot key near the root ends the walk early
+		while (n) {
+
+			visited = visited + 1;
+
+			if (precedes(key, n->value)) { // key less than current node value
+				n = n->left; // move left
+			}
+			else if (precedes(n->value, key)) { // key greater than current node value
+				n = n->right; // move right
+			}
+			else { // equivalent
+				break;
+			}
+		}
+
+		this->countProbe(visited);
+
+		if (n) { // one more access, unless the count is saturated
+			if (n->weight <= std::numeric_limits<uint64_t>::max() - detail::access_weight<true>::hit) {
+				n->weight = n->weight + detail::access_weight<true>::hit;
+			}
+			riseNode(n);
+		}
+
+		return n;
+	}
+
+	// first node not less than key, or null
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	template <typename K>
+	typename bst<T, compare_type, balance_type, alloc_type, options>::node*
+		bst<T, compare_type, balance_type, alloc_type, options>::lowerBoundNode(const K& key) const {
+
+		node* n = root; // start at the root
+		node* candidate = nullptr; // last node not less than key
+
+		size_t visited = 0; // probe length, for stats()
+
+		// one comparison per level: go left if value >= key, else right
+		while (n) {
+
+			visited = visited + 1;
+
+			if (!precedes(n->value, key)) { // value not less than key
+				candidate = n;
+				n = n->left; // move left
+			}
+			else { // value less than key
+				n = n->right; // move right
+			}
+		}
+
+		this->countProbe(visited);
+		return candidate;
+	}
+
+	// first node greater than key, or null
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	template <typename K>
+	typename bst<T, compare_type, balance_type, alloc_type, options>::node*
+		bst<T, compare_type, balance_type, alloc_type, options>::upperBoundNode(const K& key) const {
+
+		node* n = root; // start at the root
+		node* candidate = nullptr; // last node greater than key
+
+		size_t visited = 0; // probe length, for stats()
+
+		// one comparison per level: go left if value > key, else right
+		while (n) {
+
+			visited = visited + 1;
+
+			if (precedes(key, n->value)) { // value greater than key
+				candidate = n;
+				n = n->left; // move left
+			}
+			else { // value not greater than key
+				n = n->right; // move right
+			}
+		}
+
+		this->countProbe(visited);
+		return candidate;
+	}
+
+	// in-order predecessor of a node, or null before the first
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	typename bst<T, compare_type, balance_type, alloc_type, options>::node*
+		bst<T, compare_type, balance_type, alloc_type, options>::prevNode(node* n) {
+
+		if constexpr (linked) {
+			return n->prev;
+		}
+
+		if (n->left) { // rightmost node of the left subtree
+			for (n = n->left; n->right; n = n->right) {}
+			return n;
+		}
+
+		// climb until arriving from a right child
+		while (n->parent && n == n->parent->left) {
+			n = n->parent;
+		}
+
+		return n->parent;
+	}
+
+	// in-order successor of a node, or null
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	typename bst<T, compare_type, balance_type, alloc_type, options>::node*
+		bst<T, compare_type, balance_type, alloc_type, options>::nextNode(node* n) {
+
+		if constexpr (linked) {
+			return n->next;
+		}
+
+		if (n->right) { // leftmost node of the right subtree
+			for (n = n->right; n->left; n = n->left) {}
+			return n;
+		}
+
+		// climb until arriving from a left child
+		while (n->parent && n == n->parent->right) {
+			n = n->parent;
+		}
+
+		return n->parent;
+	}
+
+	// call visit on the nodes in [low, high)
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	template <typename K, typename F>
+	void bst<T, compare_type, balance_type, alloc_type, options>::visitNodes(const K& low, const K& high, F& visit) const {
+
+		// descend once to the first node in range, then follow successors;
+		// each subtree outside the range is skipped without being entered
+		for (node* n = lowerBoundNode(low); n && precedes(n->value, high); n = nextNode(n)) {
+			visit(static_cast<const T&>(n->value));
+		}
+	}
+
+	// look up a batch of keys, interleaving up to 16 descents so their misses overlap
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	template <typename ForwardIt, typename OutputIt>
+	OutputIt bst<T, compare_type, balance_type, alloc_type, options>::find_many(ForwardIt first, ForwardIt last, OutputIt out) const {
+
+		using key_type = typename std::iterator_traits<ForwardIt>::value_type;
+		constexpr size_t group = 16; // descents in flight
+
+		const key_type* keys[group]; // key of each lane
+		node* current[group]; // next node each lane visits
+		node* candidate[group]; // last node each lane found not less than its key
+
+		while (first != last) {
+
+			size_t lanes = 0; // lanes filled in this group
+
+			for (; lanes < group && first != last; ++lanes, ++first) {
+				keys[lanes] = &*first;
+				current[lanes] = root;
+				candidate[lanes] = nullptr;
+			}
+
+			// advance every lane one level per round; the node a lane moves to is
+			// prefetched and only read after the other lanes have had their turn
+			for (bool active = true; active; ) {
+
+				active = false;
+
+				for (size_t j = 0; j < lanes; ++j) {
+
+					node* n = current[j];
+
+					if (!n) { // lane finished
+						continue;
+					}
+
+					if (!precedes(n->value, *keys[j])) { // value not less than key
+						candidate[j] = n;
+						n = n->left;
+					}
+					else { // value less than key
+						n = n->right;
+					}
+
+					if (n) { // fetch the next node while the other lanes work
+						detail::prefetch(n);
+						active = true;
+					}
+
+					current[j] = n;
+				}
+			}
+
+			for (size_t j = 0; j < lanes; ++j) { // equivalence check, results in order
+
+				node* c = candidate[j];
+				*out = iterator((c && !precedes(*keys[j], c->value)) ? c : nullptr, this);
+				++out;
+			}
+		}
+
+		return out;
+	}
+
+	// first element not less than value
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	typename bst<T, compare_type, balance_type, alloc_type, options>::iterator
+		bst<T, compare_type, balance_type, alloc_type, options>::lower_bound(const T& val) const {
+		return iterator(lowerBoundNode(val), this);
+	}
+
+	// first element not less than key
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	template <typename K, typename C, typename>
+	typename bst<T, compare_type, balance_type, alloc_type, options>::iterator
+		bst<T, compare_type, balance_type, alloc_type, options>::lower_bound(const K& key) const {
+		return iterator(lowerBoundNode(key), this);
+	}
+
+	// first element greater than value
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	typename bst<T, compare_type, balance_type, alloc_type, options>::iterator
+		bst<T, compare_type, balance_type, alloc_type, options>::upper_bound(const T& val) const {
+		return iterator(upperBoundNode(val), this);
+	}
+
+	// first element greater than key
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	template <typename K, typename C, typename>
+	typename bst<T, compare_type, balance_type, alloc_type, options>::iterator
+		bst<T, compare_type, balance_type, alloc_type, options>::upper_bound(const K& key) const {
+		return iterator(upperBoundNode(key), this);
+	}
+
+	// range of elements equivalent to value
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	std::pair<typename bst<T, compare_type, balance_type, alloc_type, options>::iterator,
+		typename bst<T, compare_type, balance_type, alloc_type, options>::iterator>
+		bst<T, compare_type, balance_type, alloc_type, options>::equal_range(const T& val) const {
+
+		node* low = lowerBoundNode(val); // first node not less than value
+
+		// keys are unique: the range is empty or holds just low
+		node* high = (low && !precedes(val, low->value)) ? nextNode(low) : low;
+
+		return { iterator(low, this), iterator(high, this) };
+	}
+
+	// range of elements equivalent to key
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	template <typename K, typename C, typename>
+	std::pair<typename bst<T, compare_type, balance_type, alloc_type, options>::iterator,
+		typename bst<T, compare_type, balance_type, alloc_type, options>::iterator>
+		bst<T, compare_type, balance_type, alloc_type, options>::equal_range(const K& key) const {
+
+		node* low = lowerBoundNode(key); // first node not less than key
+
+		// keys are unique: the range is empty or holds just low
+		node* high = (low && !precedes(key, low->value)) ? nextNode(low) : low;
+
+		return { iterator(low, this), iterator(high, this) };
+	}
+
+	// visit every element in [low, high)
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	template <typename F>
+	void bst<T, compare_type, balance_type, alloc_type, options>::visit_range(const T& low, const T& high, F visit) const {
+		visitNodes(low, high, visit);
+	}
+
+	// visit every element in [low, high)
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	template <typename K, typename F, typename C, typename>
+	void bst<T, compare_type, balance_type, alloc_type, options>::visit_range(const K& low, const K& high, F visit) const {
+		visitNodes(low, high, visit);
+	}
+
+	// count elements in [low, high)
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	size_t bst<T, compare_type, balance_type, alloc_type, options>::count_range(const T& low, const T& high) const {
+		return countNodes(low, high);
+	}
+
+	// count elements in [low, high)
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	template <typename K, typename C, typename>
+	size_t bst<T, compare_type, balance_type, alloc_type, options>::count_range(const K& low, const K& high) const {
+		return countNodes(low, high);
+	}
+
+	// count nodes in [low, high): two descents with subtree sizes, else a walk
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	template <typename K>
+	size_t bst<T, compare_type, balance_type, alloc_type, options>::countNodes(const K& low, const K& high) const {
+
+		if constexpr (ranked) { // O(log n)
+
+			size_t below_low = rankOf(low); // elements before the range
+			size_t below_high = rankOf(high); // elements before the end of the range
+			return below_high > below_low ? below_high - below_low : 0;
+		}
+		else { // O(log n + k)
+
+			size_t k = 0; // elements seen
+			auto counter = [&k](const T&) { k = k + 1; };
+			visitNodes(low, high, counter);
+			return k;
+		}
+	}
+
+	// subtree size (0 for null)
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	size_t bst<T, compare_type, balance_type, alloc_type, options>::countOf(const node* n) {
+		return n ? n->count : 0;
+	}
+
+	// recompute subtree size from children
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	void bst<T, compare_type, balance_type, alloc_type, options>::recount(node* n) {
+		n->count = countOf(n->left) + countOf(n->right) + 1;
+	}
+
+	// zero-based rank of a node (size() for null, the end position)
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	size_t bst<T, compare_type, balance_type, alloc_type, options>::position(const node* n) const {
+
+		if (!n) { // past-the-end
+			return tree_size;
+		}
+
+		size_t k = countOf(n->left); // smaller elements below n
+
+		// every ancestor reached from its right adds itself and its left subtree
+		for (const node* p = n->parent; p; n = p, p = p->parent) {
+			if (n == p->right) {
+				k = k + countOf(p->left) + 1;
+			}
+		}
+
+		return k;
+	}
+
+	// number of elements less than key
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	template <typename K>
+	size_t bst<T, compare_type, balance_type, alloc_type, options>::rankOf(const K& key) const {
+
+		node* n = root; // start at the root
+		size_t k = 0; // elements known to be less than key
+
+		while (n) {
+
+			if (precedes(n->value, key)) { // n and its left subtree are less than key
+				k = k + countOf(n->left) + 1;
+				n = n->right; // move right
+			}
+			else { // value not less than key
+				n = n->left; // move left
+			}
+		}
+
+		return k;
+	}
+
+	// element at position k in sorted order
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	typename bst<T, compare_type, balance_type, alloc_type, options>::iterator
+		bst<T, compare_type, balance_type, alloc_type, options>::nth(size_t k) const {
+
+		static_assert(ranked, "nth requires the order_statistics option");
+
+		node* n = k < tree_size ? root : nullptr; // out of range is end()
+
+		while (n) {
+
+			size_t left_count = countOf(n->left); // elements before n in its subtree
+
+			if (k < left_count) { // target in left subtree
+				n = n->left;
+			}
+			else if (k == left_count) { // target is n
+				break;
+			}
+			else { // target in right subtree
+				k = k - left_count - 1;
+				n = n->right;
+			}
+		}
+
+		return iterator(n, this);
+	}
+
+	// number of elements less than value
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	size_t bst<T, compare_type, balance_type, alloc_type, options>::rank(const T& val) const {
+
+		static_assert(ranked, "rank requires the order_statistics option");
+		return rankOf(val);
+	}
+
+	// number of elements less than key
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	template <typename K, typename C, typename>
+	size_t bst<T, compare_type, balance_type, alloc_type, options>::rank(const K& key) const {
+
+		static_assert(ranked, "rank requires the order_statistics option");
+		return rankOf(key);
+	}
+
+	// finds value in tree
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	typename bst<T, compare_type, balance_type, alloc_type, options>::iterator bst<T, compare_type, balance_type, alloc_type, options>::find(const T& val) const {
+		return iterator(findNode(val), this); // null node is past-the-end
+	}
+
+	// finds value in tree, counting the hit under the frequency_weighted policy
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	typename bst<T, compare_type, balance_type, alloc_type, options>::iterator bst<T, compare_type, balance_type, alloc_type, options>::find(const T& val) {
+
+		if constexpr (weighted) {
+			return iterator(accessNode(val), this);
+		}
+		else {
+			return iterator(findNode(val), this); // null node is past-the-end
+		}
+	}
+
+	// finds key in tree without constructing T
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	template <typename K, typename C, typename>
+	typename bst<T, compare_type, balance_type, alloc_type, options>::iterator bst<T, compare_type, balance_type, alloc_type, options>::find(const K& key) const {
+		return iterator(findNode(key), this); // null node is past-the-end
+	}
+
+	// finds key in tree without constructing T, counting the hit under the frequency_weighted policy
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	template <typename K, typename C, typename>
+	typename bst<T, compare_type, balance_type, alloc_type, options>::iterator bst<T, compare_type, balance_type, alloc_type, options>::find(const K& key) {
+
+		if constexpr (weighted) {
+			return iterator(accessNode(key), this);
+		}
+		else {
+			return iterator(findNode(key), this); // null node is past-the-end
+		}
+	}
+
+	// counts elements equivalent to value
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	size_t bst<T, compare_type, balance_type, alloc_type, options>::count(const T& val) const {
+		return findNode(val) ? 1 : 0;
+	}
+
+	// counts elements equivalent to key
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	template <typename K, typename C, typename>
+	size_t bst<T, compare_type, balance_type, alloc_type, options>::count(const K& key) const {
+		return findNode(key) ? 1 : 0;
+	}
+
+	// checks for an element equivalent to value
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	bool bst<T, compare_type, balance_type, alloc_type, options>::contains(const T& val) const {
+		return findNode(val) != nullptr;
+	}
+
+	// checks for an element equivalent to key
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	template <typename K, typename C, typename>
+	bool bst<T, compare_type, balance_type, alloc_type, options>::contains(const K& key) const {
+		return findNode(key) != nullptr;
+	}
+
+	// removes the element equivalent to value
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	size_t bst<T, compare_type, balance_type, alloc_type, options>::erase(const T& val) {
+
+		node* n = findNode(val); // element to remove
+
+		if (!n) { // nothing to remove
+			return 0;
+		}
+
+		erase(iterator(n, this));
+		return 1;
+	}
+
+	// removes the element equivalent to key
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	template <typename K, typename C, typename>
+	size_t bst<T, compare_type, balance_type, alloc_type, options>::erase(const K& key) {
+
+		node* n = findNode(key); // element to remove
+
+		if (!n) { // nothing to remove
+			return 0;
+		}
+
+		erase(iterator(n, this));
+		return 1;
+	}
+
+	// removes given value from the tree
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	void bst<T, compare_type, balance_type, alloc_type, options>::erase(iterator i) {
+
+		node* n = i.curr; // node to be removed
+
+		unlinkNode(n);
+		destroyNode(n); // delete node
+	}
+
+	// unlink an element into a handle
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	typename bst<T, compare_type, balance_type, alloc_type, options>::node_type
+		bst<T, compare_type, balance_type, alloc_type, options>::extract(iterator pos) {
+
+		node* n = pos.curr; // node leaving the tree
+
+		unlinkNode(n);
+		resetNode(n);
+		return node_type(n, alloc);
+	}
+
+	// unlink the element equivalent to a value into a handle
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	typename bst<T, compare_type, balance_type, alloc_type, options>::node_type
+		bst<T, compare_type, balance_type, alloc_type, options>::extract(const T& val) {
+
+		node* n = findNode(val); // node to unlink, if any
+
+		if (!n) { // nothing equivalent
+			return node_type();
+		}
+
+		return extract(iterator(n, this));
+	}
+
+	// link the node of a handle
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	typename bst<T, compare_type, balance_type, alloc_type, options>::insert_return_type
+		bst<T, compare_type, balance_type, alloc_type, options>::insert(node_type&& handle) {
+
+		if (handle.empty()) { // nothing to insert
+			return { end(), false, node_type() };
+		}
+
+		node* parent; // node the handle's node hangs from
+		bool left; // whether it hangs as the left child
+
+		// existing node with an equivalent value
+		node* found = insertPosition(handle.held->value, parent, left);
+
+		if (found) { // the handle keeps its node
+			return { iterator(found, this), false, std::move(handle) };
+		}
+
+		node* n; // node to link
+
+		if (node_traits::is_always_equal::value || *handle.alloc == alloc) { // ours to free: link as is
+			n = handle.held;
+			handle.held = nullptr;
+		}
+		else { // the other allocator must free it: move the element over
+			n = createNode(std::move(handle.held->value));
+			node_type drop(std::move(handle)); // frees the emptied node
+		}
+
+		linkNode(n, parent, left);
+		return { iterator(n, this), true, node_type() };
+	}
+
+	// relink every element of source without an equivalent here
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	void bst<T, compare_type, balance_type, alloc_type, options>::merge(bst& source) {
+
+		if (&source == this) { // everything is already present
+			return;
+		}
+
+		bool relink = sharesAllocator(source); // whether nodes can change hands
+
+		node* n = source.root; // smallest element of source
+		for (; n && n->left; n = n->left) {}
+
+		while (n) {
+
+			node* next = nextNode(n); // unlinking n leaves the other nodes' order alone
+			node* parent; // node n would hang from
+			bool left; // whether it would hang as the left child
+
+			if (!insertPosition(n->value, parent, left)) { // no equivalent here
+
+				if (relink) {
+					source.unlinkNode(n);
+					resetNode(n);
+					linkNode(n, parent, left);
+				}
+				else {
+					linkNode(createNode(std::move(n->value)), parent, left);
+					source.erase(iterator(n, &source));
+				}
+			}
+
+			n = next;
+		}
+	}
+
+	// take a node out of the tree, relinking its successor in its place if needed
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	void bst<T, compare_type, balance_type, alloc_type, options>::unlinkNode(node* n) {
+
+		if constexpr (weighted) { // a leaf or a one-child node leaves without breaking heap order
+			sinkNode(n);
+		}
+
+		if constexpr (linked) { // neighbours close the gap
+			if (n->prev) {
+				n->prev->next = n->next;
+			}
+			if (n->next) {
+				n->next->prev = n->prev;
+			}
+		}
+
+		if constexpr (ranked) { // every ancestor of the vacated position loses one node
+
+			node* vacated = n; // position that disappears
+
+			if (n->left && n->right) { // successor's position disappears
+				vacated = n->right;
+				while (vacated->left) {
+					vacated = vacated->left;
+				}
+			}
+
+			for (node* p = vacated->parent; p; p = p->parent) {
+				p->count = p->count - 1;
+			}
+		}
+
+		node* moved = n; // node physically leaving its position
+		bool moved_red = n->red; // color leaving that position
+		node* child; // node taking the vacated position (may be null)
+		node* child_parent; // parent of that position
+
+		if (!n->left) { // node has at most a right child
+
+			child = n->right; // right child moves up
+			child_parent = n->parent;
+			transplant(n, n->right, root); // splice node out
+		}
+		else if (!n->right) { // node has only a left child
+
+			child = n->left; // left child moves up
+			child_parent = n->parent;
+			transplant(n, n->left, root); // splice node out
+		}
+		else { // node has two children
+
+			moved = n->right; // move to right child
+
+			while (moved->left) { // successor has left child
+				moved = moved->left; // move to successor's left child
+			}
+
+			moved_red = moved->red;
+			child = moved->right; // successor has no left child
+			
+			if (moved->parent == n) { // successor is node's right child
+				child_parent = moved;
+			}
+			else { // splice successor out of the right subtree
+				
+				child_parent = moved->parent;
+				transplant(moved, moved->right, root);
+				moved->right = n->right;
+				moved->right->parent = moved;
+			}
+
+			// relink the successor node in place of the erased node
+			transplant(n, moved, root);
+			moved->left = n->left;
+			moved->left->parent = moved;
+			moved->red = n->red;
+
+			if constexpr (ranked) { // successor spans n's (already reduced) subtree
+				moved->count = n->count;
+			}
+		}
+
+		tree_size = tree_size - 1; // decrement size of tree
+
+		if (balanced && !moved_red) { // a black node left its path
+			eraseFixup(child, child_parent);
+		}
+	}
+
+	// clear the links a node kept from the tree it left
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	void bst<T, compare_type, balance_type, alloc_type, options>::resetNode(node* n) {
+
+		n->left = nullptr;
+		n->right = nullptr;
+		n->parent = nullptr;
+		n->red = true; // linked nodes start red
+
+		if constexpr (ranked) {
+			n->count = 1;
+		}
+
+		if constexpr (linked) {
+			n->prev = nullptr;
+			n->next = nullptr;
+		}
+	}
+
+	// relink prev and next along an in-order walk through child and parent links
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	void bst<T, compare_type, balance_type, alloc_type, options>::threadNodes() {
+
+		if constexpr (linked) {
+
+			node* prev = nullptr; // node visited before n
+			node* n = root; // smallest node first
+			for (; n && n->left; n = n->left) {}
+
+			while (n) {
+
+				n->prev = prev;
+				if (prev) {
+					prev->next = n;
+				}
+				prev = n;
+
+				if (n->right) { // leftmost node of the right subtree
+					for (n = n->right; n->left; n = n->left) {}
+				}
+				else { // climb until arriving from a left child
+					while (n->parent && n == n->parent->right) {
+						n = n->parent;
+					}
+					n = n->parent;
+				}
+			}
+
+			if (prev) { // largest node ends the order
+				prev->next = nullptr;
+			}
+		}
+	}
+
+	// null children count as black
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	bool bst<T, compare_type, balance_type, alloc_type, options>::isRed(const node* n) {
+		return n && n->red;
+	}
+
+	// lift right child of node into its place
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	void bst<T, compare_type, balance_type, alloc_type, options>::rotateLeft(node* n, node*& top) {
+
+		node* r = n->right; // right child becomes subtree root
+		n->right = r->left; // adopt right child's left subtree
+
+		if (r->left) { // right child's left subtree exists
+			r->left->parent = n;
+		}
+
+		transplant(n, r, top); // right child takes node's place
+		r->left = n; // node becomes left child
+		n->parent = r;
+
+		if constexpr (ranked) { // r now spans n's old subtree
+			r->count = n->count;
+			recount(n);
+		}
+
+		this->countRotation();
+	}
+
+	// lift left child of node into its place
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	void bst<T, compare_type, balance_type, alloc_type, options>::rotateRight(node* n, node*& top) {
+
+		node* l = n->left; // left child becomes subtree root
+		n->left = l->right; // adopt left child's right subtree
+
+		if (l->right) { // left child's right subtree exists
+			l->right->parent = n;
+		}
+
+		transplant(n, l, top); // left child takes node's place
+		l->right = n; // node becomes right child
+		n->parent = l;
+
+		if constexpr (ranked) { // l now spans n's old subtree
+			l->count = n->count;
+			recount(n);
+		}
+
+		this->countRotation();
+	}
+
+	// rotate n above its parent for as long as it outweighs the parent
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	void bst<T, compare_type, balance_type, alloc_type, options>::riseNode(node* n) {
+
+		while (n->parent && n->weight > n->parent->weight) {
+
+			if (n == n->parent->left) { // lift left child
+				rotateRight(n->parent, root);
+			}
+			else { // lift right child
+				rotateLeft(n->parent, root);
+			}
+		}
+	}
+
+	// rotate the heavier child above n until n has at most one child
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	void bst<T, compare_type, balance_type, alloc_type, options>::sinkNode(node* n) {
+
+		while (n->left && n->right) {
+
+			if (n->left->weight > n->right->weight) { // left child takes n's place
+				rotateRight(n, root);
+			}
+			else { // right child takes n's place
+				rotateLeft(n, root);
+			}
+		}
+	}
+
+	// rotate the heavier child above n for as long as it outweighs n
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	void bst<T, compare_type, balance_type, alloc_type, options>::siftNode(node* n, node*& top) {
+
+		for (;;) {
+
+			node* c = n->left; // heavier child
+			if (!c || (n->right && n->right->weight > c->weight)) {
+				c = n->right;
+			}
+
+			if (!c || c->weight <= n->weight) { // heap order holds
+				return;
+			}
+
+			if (c == n->left) {
+				rotateRight(n, top);
+			}
+			else {
+				rotateLeft(n, top);
+			}
+		}
+	}
+
+	// sift every node of a subtree below its heavier children, bottom-up
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	void bst<T, compare_type, balance_type, alloc_type, options>::heapNodes(node* n) {
+
+		if (!n) {
+			return;
+		}
+
+		heapNodes(n->left);
+		heapNodes(n->right); // rotations below n relink its child pointers in place
+		siftNode(n, root);
+	}
+
+	// replace subtree rooted at u with subtree rooted at v in u's parent
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	void bst<T, compare_type, balance_type, alloc_type, options>::transplant(node* u, node* v, node*& top) {
+
+		if (!u->parent) { // u is the root
+			top = v;
+		}
+		else if (u == u->parent->left) { // u is a left child
+			u->parent->left = v;
+		}
+		else { // u is a right child
+			u->parent->right = v;
+		}
+
+		if (v) { // replacement exists
+			v->parent = u->parent;
+		}
+	}
+
+	// restore red-black properties after inserting red node n; returns
+	// whether the root had to be recolored black (the black height grew)
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	bool bst<T, compare_type, balance_type, alloc_type, options>::insertFixup(node* n, node*& top) {
+
+		if (!balanced) { // nothing to restore
+			return false;
+		}
+
+		// red node with red parent violates the red rule
+		while (n != top && n->parent->red) {
+
+			node* p = n->parent; // red parent is never the root
+			node* g = p->parent; // grandparent exists and is black
+
+			if (p == g->left) { // parent is a left child
+
+				node* u = g->right; // uncle
+
+				if (isRed(u)) { // red uncle: push blackness down from g
+
+					p->red = false;
+					u->red = false;
+					g->red = true;
+					n = g; // continue from grandparent
+				}
+				else { // black uncle: at most two rotations finish
+
+					if (n == p->right) { // inner child, rotate to outer
+						rotateLeft(p, top);
+						p = n;
+					}
+
+					p->red = false;
+					g->red = true;
+					rotateRight(g, top);
+					break;
+				}
+			}
+			else { // parent is a right child (mirror image)
+
+				node* u = g->left; // uncle
+
+				if (isRed(u)) { // red uncle: push blackness down from g
+
+					p->red = false;
+					u->red = false;
+					g->red = true;
+					n = g; // continue from grandparent
+				}
+				else { // black uncle: at most two rotations finish
+
+					if (n == p->left) { // inner child, rotate to outer
+						rotateRight(p, top);
+						p = n;
+					}
+
+					p->red = false;
+					g->red = true;
+					rotateLeft(g, top);
+					break;
+				}
+			}
+		}
+
+		bool grew = top->red; // red root only after pushing blackness up to it
+		top->red = false; // root is always black
+		return grew;
+	}
+
+	// restore red-black properties after a black node left the position of n
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	void bst<T, compare_type, balance_type, alloc_type, options>::eraseFixup(node* n, node* p) {
+
+		// n carries an extra black until it reaches a red node or the root
+		while (n != root && !isRed(n)) {
+
+			if (n == p->left) { // n is a left child
+
+				node* s = p->right; // sibling exists (it has black height >= 1)
+
+				if (s->red) { // red sibling: rotate to get a black one
+
+					s->red = false;
+					p->red = true;
+					rotateLeft(p, root);
+					s = p->right;
+				}
+
+				if (!isRed(s->left) && !isRed(s->right)) { // black nephews
+
+					s->red = true; // move extra black up to parent
+					n = p;
+					p = n->parent;
+				}
+				else {
+
+					if (!isRed(s->right)) { // make the far nephew red
+
+						s->left->red = false;
+						s->red = true;
+						rotateRight(s, root);
+						s = p->right;
+					}
+
+					s->red = p->red;
+					p->red = false;
+					s->right->red = false;
+					rotateLeft(p, root);
+					n = root; // extra black absorbed
+				}
+			}
+			else { // n is a right child (mirror image)
+
+				node* s = p->left; // sibling exists (it has black height >= 1)
+
+				if (s->red) { // red sibling: rotate to get a black one
+
+					s->red = false;
+					p->red = true;
+					rotateRight(p, root);
+					s = p->left;
+				}
+
+				if (!isRed(s->left) && !isRed(s->right)) { // black nephews
+
+					s->red = true; // move extra black up to parent
+					n = p;
+					p = n->parent;
+				}
+				else {
+
+					if (!isRed(s->left)) { // make the far nephew red
+
+						s->right->red = false;
+						s->red = true;
+						rotateLeft(s, root);
+						s = p->left;
+					}
+
+					s->red = p->red;
+					p->red = false;
+					s->left->red = false;
+					rotateRight(p, root);
+					n = root; // extra black absorbed
+				}
+			}
+		}
+
+		if (n) { // red node (or root) absorbs the extra black
+			n->red = false;
+		}
+	}
+
+	// move the elements not less than key into a new tree
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	bst<T, compare_type, balance_type, alloc_type, options> bst<T, compare_type, balance_type, alloc_type, options>::split(const T& key) {
+
+		bst greater(pred, get_allocator()); // shares the allocator, so nodes can move
+
+		part less = {}; // elements before key
+		part rest = {}; // elements after key
+
+		if constexpr (balanced) {
+
+			node* found; // element equivalent to key
+			splitParts(whole(), key, less, found, rest);
+
+			if (found) { // equivalent element leads the greater part
+				rest = joinParts(part{ nullptr, 0 }, found, rest);
+			}
+		}
+		else {
+			splitChain(key, less.root, rest.root);
+		}
+
+		size_t total = tree_size; // elements in both parts
+		root = less.root;
+		greater.root = rest.root;
+
+		if constexpr (linked) { // the order is cut between the two parts
+			node* last = less.root; // largest before key
+			node* first = rest.root; // smallest from key on
+			for (; last && last->right; last = last->right) {}
+			for (; first && first->left; first = first->left) {}
+
+			if (last) {
+				last->next = nullptr;
+			}
+			if (first) {
+				first->prev = nullptr;
+			}
+		}
+
+		tree_size = countFirst(less.root, rest.root, total);
+		greater.tree_size = total - tree_size;
+
+		return greater;
+	}
+
+	// append a tree of greater elements
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	void bst<T, compare_type, balance_type, alloc_type, options>::join(bst& greater) {
+
+		if (&greater == this || !greater.root) { // nothing to move
+			return;
+		}
+
+		if (!sharesAllocator(greater)) { // nodes cannot change hands
+
+			for (const T& value : greater) {
+				insert(value);
+			}
+
+			greater.clear();
+			return;
+		}
+
+		if (!root) { // take the other tree whole
+			std::swap(root, greater.root);
+			std::swap(tree_size, greater.tree_size);
+			return;
+		}
+
+		if constexpr (linked) { // the order continues from our largest into its smallest
+			node* last = root;
+			node* first = greater.root;
+			for (; last->right; last = last->right) {}
+			for (; first->left; first = first->left) {}
+			last->next = first;
+			first->prev = last;
+		}
+
+		if constexpr (balanced) {
+			root = joinParts(whole(), greater.whole()).root;
+		}
+		else {
+			root = joinChains(root, greater.root);
+		}
+
+		tree_size = tree_size + greater.tree_size;
+		greater.root = nullptr;
+		greater.tree_size = 0;
+	}
+
+	// move the elements of other in by split and join
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	void bst<T, compare_type, balance_type, alloc_type, options>::union_with(bst& other, unsigned threads) {
+
+		if (&other == this || !other.root) { // nothing to move
+			return;
+		}
+
+		if (!sharesAllocator(other)) { // nodes cannot change hands
+
+			for (const T& value : other) {
+				insert(value);
+			}
+
+			other.clear();
+			return;
+		}
+
+		if constexpr (!balanced) { // relink one by one, then drop the equivalents left behind
+			merge(other);
+			other.clear();
+			return;
+		}
+
+		size_t total = tree_size + other.tree_size; // before dropping equivalents
+		discard_list dropped; // other's equivalents of elements already here
+
+		root = unionParts(whole(), other.whole(), forkLevels(threads, total), dropped).root;
+		other.root = nullptr;
+		other.tree_size = 0;
+		tree_size = total - freeDiscards(dropped);
+		threadNodes(); // the two orders interleave
+	}
+
+	// keep the elements other also holds
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	void bst<T, compare_type, balance_type, alloc_type, options>::intersect(const bst& other, unsigned threads) {
+
+		if (&other == this) { // nothing to remove
+			return;
+		}
+
+		if constexpr (!balanced) {
+			filterNodes(other, false);
+			return;
+		}
+
+		discard_list dropped; // subtrees of elements other lacks
+
+		root = intersectParts(whole(), other.root, forkLevels(threads, tree_size + other.tree_size), dropped).root;
+		tree_size = tree_size - freeDiscards(dropped);
+		threadNodes();
+	}
+
+	// remove the elements other holds
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	void bst<T, compare_type, balance_type, alloc_type, options>::difference(const bst& other, unsigned threads) {
+
+		if (&other == this) { // everything goes
+			clear();
+			return;
+		}
+
+		if constexpr (!balanced) {
+			filterNodes(other, true);
+			return;
+		}
+
+		discard_list dropped; // elements other holds
+
+		root = differenceParts(whole(), other.root, forkLevels(threads, tree_size + other.tree_size), dropped).root;
+		tree_size = tree_size - freeDiscards(dropped);
+		threadNodes();
+	}
+
+	// visit every element, subtrees on separate threads
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	template <typename F>
+	void bst<T, compare_type, balance_type, alloc_type, options>::parallel_for_each(F f, unsigned threads) const {
+		forEachNodes(root, f, forkLevels(threads, tree_size));
+	}
+
+	// fold every element in order, subtrees on separate threads
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	template <typename R, typename Map, typename Combine>
+	R bst<T, compare_type, balance_type, alloc_type, options>::parallel_reduce(R identity, Map map, Combine combine, unsigned threads) const {
+		return reduceNodes(root, identity, map, combine, forkLevels(threads, tree_size));
+	}
+
+	// the tree as a part, with its black height read off the left spine
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	typename bst<T, compare_type, balance_type, alloc_type, options>::part
+		bst<T, compare_type, balance_type, alloc_type, options>::whole() const {
+
+		size_t black = 0; // black nodes on the leftmost path
+
+		if constexpr (balanced) {
+			for (const node* n = root; n; n = n->left) {
+				black = black + (n->red ? 0 : 1);
+			}
+		}
+
+		return part{ root, black };
+	}
+
+	// cut child c of p's root loose as a part of its own
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	typename bst<T, compare_type, balance_type, alloc_type, options>::part
+		bst<T, compare_type, balance_type, alloc_type, options>::detach(node* c, const part& p) {
+
+		if (!c) { // empty part
+			return part{ nullptr, 0 };
+		}
+
+		c->parent = nullptr;
+
+		if constexpr (!balanced) { // heights are not tracked
+			return part{ c, 0 };
+		}
+
+		size_t black = p.black - 1; // p's root is black, c's paths miss only it
+
+		if (c->red) { // a part's root is black: one more on every path
+			c->red = false;
+			black = black + 1;
+		}
+
+		return part{ c, black };
+	}
+
+	// join l, k and r, descending the taller part's inner spine to the
+	// shorter one's black height and fixing up from there: O(height difference)
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	typename bst<T, compare_type, balance_type, alloc_type, options>::part
+		bst<T, compare_type, balance_type, alloc_type, options>::joinParts(part l, node* k, part r) {
+
+		k->parent = nullptr;
+
+		if (!balanced || l.black == r.black) { // k on top of both
+
+			k->left = l.root;
+			k->right = r.root;
+			k->red = false;
+
+			if (l.root) {
+				l.root->parent = k;
+			}
+			if (r.root) {
+				r.root->parent = k;
+			}
+
+			if constexpr (ranked) {
+				recount(k);
+			}
+
+			return part{ k, balanced ? l.black + 1 : 0 };
+		}
+
+		bool taller_left = l.black > r.black; // which part k descends into
+		part& tall = taller_left ? l : r;
+		part& low = taller_left ? r : l;
+
+		node* top = tall.root; // root of the joined tree
+		node* p = nullptr; // parent of c
+		node* c = tall.root; // node k takes the place of
+		size_t black = tall.black; // black height of c
+
+		// first black node (or null) on the inner spine as low as the shorter part
+		while (isRed(c) || black > low.black) {
+
+			black = black - (isRed(c) ? 0 : 1);
+			p = c;
+			c = taller_left ? c->right : c->left;
+		}
+
+		// k becomes a red child of p, between c and the shorter part
+		k->left = taller_left ? c : low.root;
+		k->right = taller_left ? low.root : c;
+		k->red = true;
+		k->parent = p;
+
+		if (c) {
+			c->parent = k;
+		}
+		if (low.root) {
+			low.root->parent = k;
+		}
+
+		if (taller_left) {
+			p->right = k;
+		}
+		else {
+			p->left = k;
+		}
+
+		if constexpr (ranked) { // k's subtree is new; its ancestors gained low and k
+			recount(k);
+			for (node* a = p; a; a = a->parent) {
+				a->count = a->count + countOf(low.root) + 1;
+			}
+		}
+
+		bool grew = insertFixup(k, top); // only red-red violations above k
+
+		return part{ top, tall.black + (grew ? 1 : 0) };
+	}
+
+	// join two parts through the largest node of the left one
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	typename bst<T, compare_type, balance_type, alloc_type, options>::part
+		bst<T, compare_type, balance_type, alloc_type, options>::joinParts(part l, part r) {
+
+		if (!l.root) {
+			return r;
+		}
+		if (!r.root) {
+			return l;
+		}
+
+		part rest; // l without its largest node
+		node* last; // largest node of l
+		splitLast(l, rest, last);
+
+		return joinParts(rest, last, r);
+	}
+
+	// split a part around key, rejoining the subtrees on each side on the way up
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	template <typename K>
+	void bst<T, compare_type, balance_type, alloc_type, options>::splitParts(part t, const K& key,
+		part& less, node*& found, part& greater) {
+
+		node* n = t.root; // node to place on one side
+
+		if (!n) { // empty part
+			less = part{ nullptr, 0 };
+			greater = part{ nullptr, 0 };
+			found = nullptr;
+			return;
+		}
+
+		part l = detach(n->left, t); // n's subtrees as parts
+		part r = detach(n->right, t);
+
+		if (precedes(key, n->value)) { // n and r go right
+
+			part rest; // elements of l after key
+			splitParts(l, key, less, found, rest);
+			greater = joinParts(rest, n, r);
+		}
+		else if (precedes(n->value, key)) { // l and n go left
+
+			part rest; // elements of r before key
+			splitParts(r, key, rest, found, greater);
+			less = joinParts(l, n, rest);
+		}
+		else { // n is the equivalent, detached on its own
+
+			n->left = nullptr;
+			n->right = nullptr;
+
+			if constexpr (ranked) {
+				n->count = 1;
+			}
+
+			less = l;
+			found = n;
+			greater = r;
+		}
+	}
+
+	// split off the largest node down the right spine
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	void bst<T, compare_type, balance_type, alloc_type, options>::splitLast(part t, part& rest, node*& last) {
+
+		node* n = t.root; // root of the part
+		part l = detach(n->left, t); // n's subtrees as parts
+		part r = detach(n->right, t);
+
+		if (!r.root) { // n is the largest
+
+			n->left = nullptr;
+
+			if constexpr (ranked) {
+				n->count = 1;
+			}
+
+			rest = l;
+			last = n;
+			return;
+		}
+
+		part rest_right; // r without its largest node
+		splitLast(r, rest_right, last);
+		rest = joinParts(l, n, rest_right);
+	}
+
+	// union: split b around a's root, unite the sides, join through the root
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	typename bst<T, compare_type, balance_type, alloc_type, options>::part
+		bst<T, compare_type, balance_type, alloc_type, options>::unionParts(part a, part b, unsigned forks, discard_list& dropped) {
+
+		if (!a.root) {
+			return b;
+		}
+		if (!b.root) {
+			return a;
+		}
+
+		node* k = a.root; // divides both trees
+		part a_less = detach(k->left, a);
+		part a_greater = detach(k->right, a);
+
+		part b_less; // b's elements before k
+		part b_greater; // b's elements after k
+		node* equivalent; // b's element equivalent to k
+		splitParts(b, k->value, b_less, equivalent, b_greater);
+
+		if (equivalent) { // already present
+			discard(dropped, equivalent);
+		}
+
+		part l; // union of the smaller elements
+		part r; // union of the greater elements
+		discard_list dropped_left; // kept apart while the sides may run concurrently
+
+		detail::fork(forks > 0,
+			[&] { l = unionParts(a_less, b_less, forks ? forks - 1 : 0, dropped_left); },
+			[&] { r = unionParts(a_greater, b_greater, forks ? forks - 1 : 0, dropped); });
+
+		append(dropped, dropped_left);
+		return joinParts(l, k, r);
+	}
+
+	// intersection: split a around b's root, keep the equivalent if there is one
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	typename bst<T, compare_type, balance_type, alloc_type, options>::part
+		bst<T, compare_type, balance_type, alloc_type, options>::intersectParts(part a, const node* b, unsigned forks, discard_list& dropped) {
+
+		if (!a.root) {
+			return a;
+		}
+
+		if (!b) { // nothing of a is kept
+			discard(dropped, a.root);
+			return part{ nullptr, 0 };
+		}
+
+		part a_less; // a's elements before b's root
+		part a_greater; // a's elements after b's root
+		node* equivalent; // a's element equivalent to b's root
+		splitParts(a, b->value, a_less, equivalent, a_greater);
+
+		part l; // intersection of the smaller elements
+		part r; // intersection of the greater elements
+		discard_list dropped_left; // kept apart while the sides may run concurrently
+
+		detail::fork(forks > 0,
+			[&] { l = intersectParts(a_less, b->left, forks ? forks - 1 : 0, dropped_left); },
+			[&] { r = intersectParts(a_greater, b->right, forks ? forks - 1 : 0, dropped); });
+
+		append(dropped, dropped_left);
+		return equivalent ? joinParts(l, equivalent, r) : joinParts(l, r);
+	}
+
+	// difference: split a around b's root, drop the equivalent if there is one
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	typename bst<T, compare_type, balance_type, alloc_type, options>::part
+		bst<T, compare_type, balance_type, alloc_type, options>::differenceParts(part a, const node* b, unsigned forks, discard_list& dropped) {
+
+		if (!a.root || !b) { // nothing of a is removed
+			return a;
+		}
+
+		part a_less; // a's elements before b's root
+		part a_greater; // a's elements after b's root
+		node* equivalent; // a's element equivalent to b's root
+		splitParts(a, b->value, a_less, equivalent, a_greater);
+
+		if (equivalent) { // removed
+			discard(dropped, equivalent);
+		}
+
+		part l; // difference of the smaller elements
+		part r; // difference of the greater elements
+		discard_list dropped_left; // kept apart while the sides may run concurrently
 
-				curr = curr->left; // move to left child
+		detail::fork(forks > 0,
+			[&] { l = differenceParts(a_less, b->left, forks ? forks - 1 : 0, dropped_left); },
+			[&] { r = differenceParts(a_greater, b->right, forks ? forks - 1 : 0, dropped); });
 
-				while (curr->right) { // current node has right child
+		append(dropped, dropped_left);
+		return joinParts(l, r);
+	}
 
-					curr = curr->right; // move to right child
-				}
-			}
-			else { // current does not have left
+	// cut the tree along the search path for key: each node on it takes its
+	// subtree on the far side along, hanging where the previous one left off
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	void bst<T, compare_type, balance_type, alloc_type, options>::splitChain(const T& key, node*& less, node*& greater) {
 
-				auto p = curr->parent; // current's parent
+		node** less_slot = &less; // where the next node before key hangs
+		node** greater_slot = &greater; // where the next node from key on hangs
+		node* less_last = nullptr; // parent of less_slot
+		node* greater_last = nullptr; // parent of greater_slot
 
-				while (curr == p->left) { // current is parent's left child
+		for (node* n = root; n; ) {
 
-					curr = p; // move to parent node
-					p = p->parent; // update parent
-				}
+			node* next; // continue down the side not yet placed
 
-				curr = p; // current is right child, move to parent
+			if (precedes(n->value, key)) { // n and its left subtree go before key
+				*less_slot = n;
+				n->parent = less_last;
+				less_last = n;
+				less_slot = &n->right;
+				next = n->right;
+			}
+			else { // n and its right subtree go from key on
+				*greater_slot = n;
+				n->parent = greater_last;
+				greater_last = n;
+				greater_slot = &n->left;
+				next = n->left;
 			}
-			return copy;
-		}
 
-		/**
-		* overloaded == comparison operator
-		*/
-		friend bool operator==(const iterator& left, const iterator& right) {
-			
-			/* whether left iterator's current node is
-			right iterator's current node */
-			return left.curr == right.curr;
+			n = next;
 		}
 
-		/**
-		* overloaded != comparison operator
-		*/
-		friend bool operator!=(const iterator& left, const iterator& right) {
+		*less_slot = nullptr;
+		*greater_slot = nullptr;
 
-			/* whether left iterator's current node is not
-			right iterator's current node */
-			return left.curr != right.curr;
+		if constexpr (ranked) { // only the path nodes lost part of their subtrees
+			for (node* a = less_last; a; a = a->parent) {
+				recount(a);
+			}
+			for (node* a = greater_last; a; a = a->parent) {
+				recount(a);
+			}
 		}
+	}
 
-		/**
-		* overload dereferencing operator (without modifying tree element)
-		*/
-		const T& operator*() const {
-			return curr->value; // value contained by current node
-		}
+	// zip l's right spine with r's left spine, heavier node first under
+	// frequency_weighted and l's whole spine first otherwise
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	typename bst<T, compare_type, balance_type, alloc_type, options>::node*
+		bst<T, compare_type, balance_type, alloc_type, options>::joinChains(node* l, node* r) {
 
-		/**
-		* overload the operator arrow (without modifying tree element)
-		*/
-		const T* operator->() const {
-			return &curr->value; // value contained by current node
-		}
+		node* top = nullptr; // root of the joined tree
+		node** slot = &top; // where the next spine node hangs
+		node* last = nullptr; // parent of slot
 
-	private:
+		while (l && r) {
 
-		/**
-		* constructor which initializes curr and container
-		* @param n the current node
-		* @param c the tree container
-		*/
-		iterator(node* n = nullptr, const bst* c = nullptr) :
-			curr(n), container(c) {}
+			bool left_first; // whether l's spine node goes above r's
 
-		node* curr; //current position
-		const bst* container; // holding container
-	};
+			if constexpr (weighted) { // keep the heap order
+				left_first = l->weight > r->weight;
+			}
+			else {
+				left_first = true;
+			}
 
-	// destructor which passes the implicit root to deleteTree
-	template <typename T, typename compare_type>
-	void bst<T, compare_type>::deleteTree(node* n) {
-		
-		if (n) { // node exists
-			
-			if (n->left) { // left child is not null
-				deleteTree(n->left); // recurse on left node
+			if (left_first) { // l's node keeps its left subtree, the rest hangs right
+				*slot = l;
+				l->parent = last;
+				last = l;
+				slot = &l->right;
+				l = l->right;
 			}
-			
-			if (n->right) { // right child is not null
-				deleteTree(n->right); // recurse on right node
+			else { // r's node keeps its right subtree, the rest hangs left
+				*slot = r;
+				r->parent = last;
+				last = r;
+				slot = &r->left;
+				r = r->left;
+			}
+		}
+
+		*slot = l ? l : r; // the spine that is left over
+		if (*slot) {
+			(*slot)->parent = last;
+		}
+
+		if constexpr (ranked) { // the zipped path gained the other tree's nodes
+			for (node* a = last; a; a = a->parent) {
+				recount(a);
 			}
-			
-			delete n; // delete node
 		}
+
+		return top;
 	}
 
-	// to help with copying
-	template <typename T, typename compare_type>
-	void bst<T, compare_type>::traverseInsert(node* n) {
+	// walk both trees in order, erasing the elements whose presence in other is drop_present
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	void bst<T, compare_type, balance_type, alloc_type, options>::filterNodes(const bst& other, bool drop_present) {
 
-			insert(n->value); // insert value
-			
-			if (n->left) { // left node exists
-				traverseInsert(n->left); // recurse on left node
+		node* n = root; // next element here
+		node* o = other.root; // first element of other not before n
+		for (; n && n->left; n = n->left) {}
+		for (; o && o->left; o = o->left) {}
+
+		while (n) {
+
+			node* next = nextNode(n); // erasing n leaves the other nodes in place
+
+			while (o && precedes(o->value, n->value)) {
+				o = nextNode(o);
 			}
-			
-			if (n->right) { // right node exists
-				traverseInsert(n->right); // recurse on right node
+
+			bool present = o && !precedes(n->value, o->value); // other holds an equivalent
+
+			if (present == drop_present) {
+				erase(iterator(n, this));
 			}
-	}
 
-	// copy constructor
-	template <typename T, typename compare_type>
-	bst<T, compare_type>::bst(const bst& rhs) : root(nullptr), pred(rhs.pred) {
-		
-		traverseInsert(rhs.root); // helper function to recursively copy nodes
+			n = next;
+		}
 	}
 
-	// move constructor
-	template <typename T, typename compare_type>
-	bst<T, compare_type>::bst(bst&& that) noexcept : bst() {
-		
-		(*this).swap(that); // swap implicit tree with given tree
-	}
+	// chain a detached subtree through its root's parent link
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	void bst<T, compare_type, balance_type, alloc_type, options>::discard(discard_list& list, node* n) {
 
-	// copy/move assignment operator
-	template <typename T, typename compare_type>
-	bst<T, compare_type>& bst<T, compare_type>::operator=(bst that) & {
-		
-		(*this).swap(that); // swap implicit tree with given tree
-		return *this; // return implicit tree
+		n->parent = nullptr; // end of the chain
+
+		if (list.tail) {
+			list.tail->parent = n;
+		}
+		else {
+			list.head = n;
+		}
+
+		list.tail = n;
 	}
 
-	// swap two Trees (member function)
-	template <typename T, typename compare_type>
-	void bst<T, compare_type>::swap(bst& other) {
-		
-		// swap root of implicit tree with given tree
-		std::swap(this->root, other.root);
+	// move the chain of from onto the end of list
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	void bst<T, compare_type, balance_type, alloc_type, options>::append(discard_list& list, discard_list& from) {
 
-		// swap predicate of implicit tree with given tree
-		std::swap(this->pred, other.pred);
+		if (!from.head) { // nothing to move
+			return;
+		}
 
-		// swap tree_size of implicit tree with given tree
-		std::swap(this->tree_size, other.tree_size);
+		if (list.tail) {
+			list.tail->parent = from.head;
+		}
+		else {
+			list.head = from.head;
+		}
+
+		list.tail = from.tail;
+		from = discard_list();
 	}
 
-	// swap two Trees (free function)
-	template <typename T, typename compare_type>
-	void swap(bst<T, compare_type>& first, bst<T, compare_type>& second) {
+	// free the chained subtrees on the calling thread
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	size_t bst<T, compare_type, balance_type, alloc_type, options>::freeDiscards(discard_list& list) {
 
-		first.swap(second); // use member function to swap first tree with second
+		size_t freed = 0; // nodes freed so far
+
+		while (list.head) {
+
+			node* n = list.head;
+			list.head = n->parent;
+			n->parent = nullptr; // deleteTree stops above n
+			freed = freed + deleteTree(n);
+		}
+
+		list.tail = nullptr;
+		return freed;
 	}
 
-	// iterator to begin position (farthest left node)
-	template <typename T, typename compare_type>
-	typename bst<T, compare_type>::iterator bst<T, compare_type>::begin() const {
-		
-		if (!root) { // root is null (tree is empty)
+	// whether nodes allocated by other's allocator can be freed by ours
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	bool bst<T, compare_type, balance_type, alloc_type, options>::sharesAllocator(const bst& other) const {
 
-			// return iterator to past-the-end position (nullptr)
-			return iterator(nullptr, this);
+		if constexpr (node_traits::is_always_equal::value) {
+			return true;
 		}
-		
-		node* n = root; // start at the root
-		
-		while (n->left) { // left child is not null
-			n = n->left; // go left
+		else {
+			return alloc == other.alloc;
 		}
-		
-		return iterator(n, this); // iterator to node containing smallest value
 	}
 
-	// iterator to past-the-end position (nullptr)
-	template <typename T, typename compare_type>
-	typename bst<T, compare_type>::iterator bst<T, compare_type>::end() const {
-		return iterator(nullptr, this); // iterator to nullptr
-	}
+	// fork enough levels for two tasks per thread, and none for small trees
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	unsigned bst<T, compare_type, balance_type, alloc_type, options>::forkLevels(unsigned threads, size_t work) {
 
-	// to add a value to the tree (lvalue)
-	template <typename T, typename compare_type>
-	void bst<T, compare_type>::insert(const T& val) {
+		const size_t grain = 1 << 15; // below this a thread costs more than it saves
 
-		if (!root) { // root is null (tree is empty)
-			
-			root = new node(val); // create a new node
-			tree_size = tree_size + 1; // increment size of tree
+		if (!threads) { // one per core
+			threads = std::thread::hardware_concurrency();
 		}
 
-		else { // root node exists
-
-			node* n = new node(val); // create a new node
+		if (threads <= 1 || work < grain) {
+			return 0;
+		}
 
-			// recursively pass it node to node until in place
-			// true if node was sucessfully inserted
-			bool insert_successful = root->insertNode(n, pred); 
-			
-			if (insert_successful) { // node was sucessfully inserted
-				tree_size = tree_size + 1; // increment size of tree
-			}
+		unsigned levels = 1; // 2^levels tasks
+		while ((1u << levels) < threads) {
+			levels = levels + 1;
 		}
-	}
 
-	// to add a value to the tree (rvalue)
-	template <typename T, typename compare_type>
-	void bst<T, compare_type>::insert(T&& val) {
+		return levels + 1;
+	}
 
-		if (!root) { // root is nullptr
+	// count the first of two parts by walking both until the smaller ends
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	size_t bst<T, compare_type, balance_type, alloc_type, options>::countFirst(node* a, node* b, size_t total) {
 
-			root = new node(std::move(val)); //create a new node
-			tree_size = tree_size + 1; // increment size of tree
+		if constexpr (ranked) { // sizes are stored
+			return countOf(a);
 		}
-		else { // root is not nullptr
 
-			node* n = new node(std::move(val)); // create a new node
+		for (; a && a->left; a = a->left) {} // leftmost node of each part
+		for (; b && b->left; b = b->left) {}
 
-			// recursively pass it node to node until in place
-			// true if node was sucessfully inserted
-			bool insert_successful = root->insertNode(n, pred);
+		size_t steps = 0; // nodes passed in each part
 
-			if (insert_successful) { // node was sucessfully inserted
-				tree_size = tree_size + 1; // increment size of tree
-			}
+		while (a && b) {
+			a = nextNode(a);
+			b = nextNode(b);
+			steps = steps + 1;
 		}
-	}
 
-	// nested node class definition
-	template <typename T, typename compare_type>
-	class bst<T, compare_type>::node {
-		
-		friend bst; // tree member functions may search through nodes
-		friend iterator; // to be able to advance by checking node values
-	
-	private:
+		return a ? total - steps : steps;
+	}
 
-		/**
-		* constructor which initializes value, left, right, and parent
-		*/
-		node(T val) : value(std::move(val)), left(nullptr),
-			right(nullptr), parent(nullptr) {}
+	// visit a subtree, forking the top levels
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	template <typename F>
+	void bst<T, compare_type, balance_type, alloc_type, options>::forEachNodes(node* n, F& f, unsigned forks) const {
 
-		node* left; // left child node
-		node* right; // right child node
-		node* parent; // parent node
+		if (!forks) { // serial from here
+			walkSubtree(n, f);
+			return;
+		}
 
-		T value; // data value stored
+		if (!n) { // empty subtree
+			return;
+		}
 
-		/**
-		* insert() helper function to insert node into tree
-		* @param n the node to be inserted
-		* @param p the predicate function to compare nodes
-		* @return whether the node was successfully inserted
-		*/
-		bool insertNode(node* n, compare_type p);
-	};
+		detail::fork(true,
+			[&] { forEachNodes(n->left, f, forks - 1); },
+			[&] {
+				f(static_cast<const T&>(n->value));
+				forEachNodes(n->right, f, forks - 1);
+			});
+	}
 
-	// helper function to insert node into tree
-	template<typename T, typename compare_type>
-	bool bst<T, compare_type>::node::insertNode(node* n, compare_type pred) {
-		
-		// value is less than new node value
-		if (pred(value, n->value)) {
+	// fold a subtree, forking the top levels
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	template <typename R, typename Map, typename Combine>
+	R bst<T, compare_type, balance_type, alloc_type, options>::reduceNodes(node* n, const R& identity,
+		Map& map, Combine& combine, unsigned forks) const {
 
-			if (right) { // right child exists
+		if (!forks) { // serial from here
 
-				right->insertNode(n, pred); // recurse on the right child
-			}
+			R folded = identity; // running fold
 
-			else { // right child does not exist
+			auto step = [&](const T& value) { folded = combine(std::move(folded), map(value)); };
+			walkSubtree(n, step);
+			return folded;
+		}
 
-				right = n; // set right child to node
-				n->parent = this; // set parent for node
-				return true; // indicate insertion was successful
-			}
+		if (!n) { // empty subtree
+			return identity;
 		}
 
-		// value is greater than new node value
-		else if (pred(n->value, value)) {
+		R l = identity; // fold of the left subtree
+		R r = identity; // fold of the right subtree
 
-			if (left) { // left child exists
+		detail::fork(true,
+			[&] { l = reduceNodes(n->left, identity, map, combine, forks - 1); },
+			[&] { r = reduceNodes(n->right, identity, map, combine, forks - 1); });
 
-				left->insertNode(n, pred); // recurse on the left child
-			}
-			else { // left child does not exist
+		return combine(combine(std::move(l), map(static_cast<const T&>(n->value))), std::move(r));
+	}
 
-				left = n; // set left child to node
-				n->parent = this; // set parent for node
-				return true; // indicate insertion was successful
-			}
+	// in-order walk of one subtree through parent links
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	template <typename F>
+	void bst<T, compare_type, balance_type, alloc_type, options>::walkSubtree(node* n, F& f) {
+
+		if (!n) { // empty subtree
+			return;
 		}
 
-		// value neither less than or greater than new node value
-		else {
+		node* last = n; // largest node of the subtree
+		for (; last->right; last = last->right) {}
+
+		node* stop = nextNode(last); // first node past the subtree, or null
+		for (; n->left; n = n->left) {}
 
-			delete n; // free the allocated node memory
-			return false; // indicate insertion was not successful
+		for (; n != stop; n = nextNode(n)) {
+			f(static_cast<const T&>(n->value));
 		}
 	}
 
-	// finds value in tree
-	template <typename T, typename compare_type>
-	typename bst<T, compare_type>::iterator bst<T, compare_type>::find(const T& val) const {
-		
-		if (!root) { // root is null (tree is empty)
-			
-			return iterator(nullptr, this); // past-the-end iterator
-		}
-		
-		node* n = root; // start at the root
+	/* accepts variadic listand constructs a T and
+	attempt to place within the tree */
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	template <typename... Types>
+	std::pair<typename bst<T, compare_type, balance_type, alloc_type, options>::iterator, bool>
+		bst<T, compare_type, balance_type, alloc_type, options>::emplace(Types&&... args) {
 
-		while (true) { // loop until an iterator is returned
+		node* n = createNode(std::forward<Types>(args)...); // T built once, in place
+		node* parent; // node n hangs from
+		bool left; // whether it hangs as the left child
+		node* found; // existing node with an equivalent value
 
-			// current node value contains correct value
-			if (!pred(val, n->value) && !pred(n->value, val)) {
+		try {
+			found = insertPosition(n->value, parent, left);
+		}
+		catch (...) { // comparator threw
+			destroyNode(n);
+			throw;
+		}
 
-				return iterator(n, this); // iterator to node
-			}
+		return linkOrDestroy(n, found, parent, left);
+	}
 
-			// value less than current node value and left child exists
-			else if (pred(val, n->value) && (n->left)) {
+	// emplace, trying the position next to hint before a full search
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	template <typename... Types>
+	typename bst<T, compare_type, balance_type, alloc_type, options>::iterator
+		bst<T, compare_type, balance_type, alloc_type, options>::emplace_hint(iterator hint, Types&&... args) {
 
-				n = n->left; // move left
+		node* n = createNode(std::forward<Types>(args)...); // T built once, in place
+		node* parent; // node n hangs from
+		bool left; // whether it hangs as the left child
+		node* found = nullptr; // existing node with an equivalent value
+
+		try {
+			if (!hintPosition(hint.curr, n->value, parent, left)) { // not next to hint
+				found = insertPosition(n->value, parent, left);
 			}
+		}
+		catch (...) { // comparator threw
+			destroyNode(n);
+			throw;
+		}
 
-			// value greater than current node value and right child exists
-			else if (pred(n->value, val) && (n->right)) {
+		return linkOrDestroy(n, found, parent, left).first;
+	}
 
-				n = n->right; // move right
-			}
+	// search with the key, construct only on a miss
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	template <typename K, typename... Types>
+	std::pair<typename bst<T, compare_type, balance_type, alloc_type, options>::iterator, bool>
+		bst<T, compare_type, balance_type, alloc_type, options>::try_emplace(K&& key, Types&&... args) {
 
-			// value is not in tree
-			else {
+		static_assert(std::is_same<std::decay_t<K>, T>::value || detail::is_transparent<compare_type>::value,
+			"try_emplace with a key of another type than T needs a transparent comparator");
 
-				return iterator(nullptr, this); // past-the-end iterator
-			}
-		}
+		// key is read by the search before it is forwarded to T
+		return emplaceKey(key, std::forward<K>(key), std::forward<Types>(args)...);
 	}
 
-	// removes given value from the tree
-	template <typename T, typename compare_type>
-	void bst<T, compare_type>::erase(iterator i) {
-		
-		node* n = i.curr; // node to be removed
+	// one descent with key; the node is built from args only if nothing matches
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	template <typename K, typename... Types>
+	std::pair<typename bst<T, compare_type, balance_type, alloc_type, options>::iterator, bool>
+		bst<T, compare_type, balance_type, alloc_type, options>::emplaceKey(const K& key, Types&&... args) {
 
-		if (n->parent) { // node has parent
-			
-			// node has no children
-			if ((!n->left) && (!n->right)) {
+		node* parent; // node the new element hangs from
+		bool left; // whether it hangs as the left child
 
-				if (n->parent->left == n) { // node is left child
+		node* found = insertPosition(key, parent, left); // existing equivalent, if any
 
-					// set parent's left pointer to null
-					n->parent->left = nullptr;
-				}
+		if (found) { // nothing constructed, nothing allocated
+			return { iterator(found, this), false };
+		}
 
-				else { // node is right child
+		node* n = createNode(std::forward<Types>(args)...);
+		linkNode(n, parent, left);
 
-					// set parent's right pointer to null
-					n->parent->right = nullptr;
-				}
+		return { iterator(n, this), true };
+	}
 
-				delete n; // delete node
-			}
+	// link n where the search ended, or give it back if it is a duplicate
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	std::pair<typename bst<T, compare_type, balance_type, alloc_type, options>::iterator, bool>
+		bst<T, compare_type, balance_type, alloc_type, options>::linkOrDestroy(node* n, node* found, node* parent, bool left) {
 
-			// node has one child
-			else if ((!n->left) ^ (!n->right)) {
-				
-				if (n->left) { // node has left child
+		if (found) { // equivalent present: the new element goes
+			destroyNode(n);
+			return { iterator(found, this), false };
+		}
 
-					// set given left child's parent to given node's parent
-					n->left->parent = n->parent;
+		linkNode(n, parent, left);
+		return { iterator(n, this), true };
+	}
 
-					/* set given node's parent's left child to
-					given node's left child */
-					n->parent->left = n->left;
-				}
-				else { // node has right child
+	// a free slot between hint's predecessor and hint, or between hint and its successor
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	bool bst<T, compare_type, balance_type, alloc_type, options>::hintPosition(node* hint, const T& val,
+		node*& parent, bool& left) const {
 
-					// set given right child's parent to given node's parent
-					n->right->parent = n->parent;
+		node* before; // last node that must precede val
 
-					/* set given node's parent's right child to
-					given node's right child */
-					n->parent->right = n->right;
-				}
-				delete n; // delete node
-			}
-			else { // node has two children
-				
-				node* temp = n; // copy of node
+		if (hint) {
+			before = prevNode(hint);
+		}
+		else { // end(): before the past-the-end position is the largest element
+			before = root;
+			for (; before && before->right; before = before->right) {}
+		}
 
-				temp = temp->right; // move to copy's right child
+		if ((!hint || precedes(val, hint->value)) && (!before || precedes(before->value, val))) { // just before hint
 
-				while (temp->left) { // copied node has left child
-					temp = temp->left; // move to copy's left child
-				}
+			// hint's left slot is free, or else the predecessor's right slot is
+			left = hint && !hint->left;
+			parent = left ? hint : before;
+			return true;
+		}
 
-				// set given node's value with the right-far-left value
-				n->value = temp->value;
-				
-				// construct iterator to right-far-left node
-				iterator recurse(temp, this);
+		if (hint && precedes(hint->value, val)) { // maybe just after hint
 
-				// remove the right-far-left node with zero or one child
-				erase(recurse);
+			node* after = nextNode(hint); // first node that must follow val
+
+			if (!after || precedes(val, after->value)) {
+
+				// hint's right slot is free, or else the successor's left slot is
+				left = hint->right != nullptr;
+				parent = left ? after : hint;
+				return true;
 			}
 		}
-		else { // node does not have a parent
-			
-			// node has no children
-			if ((!n->left) && (!n->right)) {
 
-				delete n; // delete node
-			}
+		return false; // equivalent to a neighbour, or not next to hint
+	}
+
+	// accessor to tree_size
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	size_t bst<T, compare_type, balance_type, alloc_type, options>::size() const {
+		return tree_size;
+	}
 
-			// node has one child
-			else if ((!n->left) ^ (!n->right)) {
+	// number of nodes on the longest root-to-leaf path
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	size_t bst<T, compare_type, balance_type, alloc_type, options>::height() const {
 
-				if (n->left) { // node has left child
+		size_t longest = 0; // deepest level reached so far
+		size_t depth = 0; // level of current node
+		const node* n = root; // current node
+		const node* prev = nullptr; // node visited before current node
 
-					// set given left child's parent to nullptr
-					n->left->parent = nullptr;
+		// walk the tree through parent links without a stack
+		while (n) {
 
-					root = n->left; // set root to left child
-				}
-				else { // node has right child
+			const node* next; // node to visit after current node
 
-					// set given right child's parent to nullptr
-					n->right->parent = nullptr;
+			if (prev == n->parent) { // arrived from above
 
-					root = n->right; // set root to right child
-				}
-				delete n; // delete node
+				depth = depth + 1;
+				longest = depth > longest ? depth : longest;
+				next = n->left ? n->left : (n->right ? n->right : n->parent);
+			}
+			else if (prev == n->left && n->right) { // left subtree done
+				next = n->right;
+			}
+			else { // both subtrees done
+				next = n->parent;
 			}
 
-			// node has two children
-			else {
-				
-				node* temp = n; // copy of node
-				temp = temp->right; // move to copy's right child
+			if (next == n->parent) { // leaving current node
+				depth = depth - 1;
+			}
 
-				while (temp->left) { // copied node has left child
-					temp = temp->left; // move to copy's left child
-				}
+			prev = n;
+			n = next;
+		}
+
+		return longest;
+	}
 
-				// set given node's value with the right-far-left value
-				n->value = temp->value;
+	// accessor to a copy of the allocator
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	alloc_type bst<T, compare_type, balance_type, alloc_type, options>::get_allocator() const {
+		return alloc_type(alloc);
+	}
+
+	// accessor to a copy of the comparison function
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	compare_type bst<T, compare_type, balance_type, alloc_type, options>::key_comp() const {
+		return pred;
+	}
 
-				// construct iterator to right-far-left node
-				iterator recurse(temp, this);
+	// snapshot of the operation counters, with the height measured now
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	bst_stats bst<T, compare_type, balance_type, alloc_type, options>::stats() const {
 
-				// remove the right-far-left node with zero or one child
-				erase(recurse);
-			}
+		static_assert(counted, "stats() requires the statistics option");
+
+		static_assert(std::tuple_size<decltype(bst_stats::probe_lengths)>::value == detail::tree_counters<true>::buckets,
+			"bst_stats must hold every probe bucket");
+
+		bst_stats snapshot;
+		snapshot.comparisons = this->comparisons.load(std::memory_order_relaxed);
+		snapshot.allocations = this->allocations.load(std::memory_order_relaxed);
+		snapshot.frees = this->frees.load(std::memory_order_relaxed);
+		snapshot.rotations = this->rotations.load(std::memory_order_relaxed);
+		snapshot.iterator_steps = this->steps.load(std::memory_order_relaxed);
+		snapshot.size = tree_size;
+		snapshot.height = height();
+
+		for (size_t i = 0; i < snapshot.probe_lengths.size(); ++i) {
+			snapshot.probe_lengths[i] = this->probes[i].load(std::memory_order_relaxed);
 		}
+
+		return snapshot;
 	}
 
-	/* accepts variadic listand constructs a T and
-	attempt to place within the tree */
-	template <typename T, typename compare_type>
-	template <typename... Types>
-	void bst<T, compare_type>::emplace(Types&&... args) {
+	// zero the operation counters
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	void bst<T, compare_type, balance_type, alloc_type, options>::reset_stats() {
 
-		// construct and insert an object of type T
-		insert(T(std::forward<Types>(args)...));
-	}
+		static_assert(counted, "reset_stats() requires the statistics option");
 
-	// accessor to tree_size
-	template <typename T, typename compare_type>
-	size_t bst<T, compare_type>::size() const {
-		return tree_size;
+		this->comparisons.store(0, std::memory_order_relaxed);
+		this->allocations.store(0, std::memory_order_relaxed);
+		this->frees.store(0, std::memory_order_relaxed);
+		this->rotations.store(0, std::memory_order_relaxed);
+		this->steps.store(0, std::memory_order_relaxed);
+
+		for (auto& bucket : this->probes) {
+			bucket.store(0, std::memory_order_relaxed);
+		}
 	}
 }
 
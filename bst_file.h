@@ -0,0 +1,723 @@
+#ifndef BST_FILE_H
+#define BST_FILE_H
+
+#include <utility>
+#include <functional>
+#include <algorithm>
+#include <iterator>
+#include <type_traits>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+#include <string>
+#include <istream>
+#include <ostream>
+#include <fstream>
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#define BST_FILE_MMAP 1
+#endif
+
+#include "bst.h"
+
+/*
+* on-disk format, version 1, in native byte order (a file written on a
+* machine of the other byte order fails the version check):
+*
+*   header   32 bytes: magic "BSTFILE\0", version (u32), element size (u32,
+*            0 when it varies), element count (u64), reserved (u64, 0)
+*   payload  bitwise codecs: count * element size bytes, the elements in order
+*            other codecs: blocks of a byte length (u32) and that many bytes of
+*            whole encoded elements, ended by a block of length 0
+*   trailer  checksum (u64) of the header and the payload
+*
+* the payload of a bitwise codec starts 32 bytes into the file, so a mapped
+* file can be searched in place by mapped_bst
+*/
+
+namespace binarysearch {
+
+	/**
+	* encodes elements for save and decodes them for load; specialize for other
+	* types with: fixed_size (bytes per element, 0 if it varies), bitwise
+	* (whether the encoding is the object representation itself),
+	* static void encode(const T&, std::string& out) appending the bytes, and
+	* static T decode(const char*& p, const char* end) reading them and
+	* advancing p, throwing std::runtime_error if they run out
+	* the default handles trivially copyable T by copying its bytes
+	*/
+	template <typename T, typename = void>
+	struct codec;
+
+	template <typename T>
+	struct codec<T, std::enable_if_t<std::is_trivially_copyable<T>::value>> {
+
+		static constexpr uint32_t fixed_size = sizeof(T);
+		static constexpr bool bitwise = true;
+
+		static void encode(const T& value, std::string& out) {
+			out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+		}
+
+		static T decode(const char*& p, const char* end) {
+
+			if (static_cast<size_t>(end - p) < sizeof(T)) {
+				throw std::runtime_error("bst_file: truncated element");
+			}
+
+			typename std::aligned_storage<sizeof(T), alignof(T)>::type bytes; // p may be unaligned
+			std::memcpy(&bytes, p, sizeof(T));
+			p = p + sizeof(T);
+
+			return *reinterpret_cast<const T*>(&bytes);
+		}
+	};
+
+	/**
+	* strings as a u32 byte length followed by the bytes
+	*/
+	template <>
+	struct codec<std::string> {
+
+		static constexpr uint32_t fixed_size = 0;
+		static constexpr bool bitwise = false;
+
+		static void encode(const std::string& value, std::string& out) {
+
+			if (value.size() > UINT32_MAX) {
+				throw std::length_error("bst_file: string longer than 4 GiB");
+			}
+
+			uint32_t length = static_cast<uint32_t>(value.size());
+			out.append(reinterpret_cast<const char*>(&length), sizeof(length));
+			out.append(value);
+		}
+
+		static std::string decode(const char*& p, const char* end) {
+
+			uint32_t length = codec<uint32_t>::decode(p, end); // bytes that follow
+
+			if (static_cast<size_t>(end - p) < length) {
+				throw std::runtime_error("bst_file: truncated element");
+			}
+
+			std::string value(p, length);
+			p = p + length;
+			return value;
+		}
+	};
+
+	namespace detail {
+
+		/**
+		* fixed part at the start of every file
+		*/
+		struct file_header {
+			char magic[8]; // "BSTFILE\0"
+			uint32_t version; // format version
+			uint32_t element_size; // bytes per element, 0 when it varies
+			uint64_t count; // number of elements
+			uint64_t reserved; // 0, pads the payload to a 32-byte offset
+		};
+
+		inline constexpr char file_magic[8] = { 'B', 'S', 'T', 'F', 'I', 'L', 'E', '\0' };
+		inline constexpr uint32_t file_version = 1;
+		inline constexpr size_t file_block = size_t(1) << 16; // bytes buffered per write or block
+
+		/**
+		* running 64-bit checksum: FNV-1a over 8-byte words rather than
+		* bytes, so it keeps up with the disk; the result does not depend
+		* on how the data is split across update calls
+		*/
+		class file_checksum {
+
+		public:
+
+			/**
+			* folds bytes into the checksum
+			* @param data first byte
+			* @param n number of bytes
+			*/
+			void update(const void* data, size_t n) {
+
+				const unsigned char* p = static_cast<const unsigned char*>(data);
+
+				for (; n && filled; --n) { // complete a partial word first
+					push(*p++);
+				}
+
+				for (; n >= 8; n = n - 8, p = p + 8) { // whole words
+					uint64_t w;
+					std::memcpy(&w, p, 8);
+					fold(w);
+				}
+
+				for (; n; --n) { // keep the rest for the next call
+					push(*p++);
+				}
+			}
+
+			/**
+			* checksum of every byte so far
+			* @return the checksum
+			*/
+			uint64_t value() const {
+
+				if (!filled) {
+					return state;
+				}
+
+				uint64_t w = 0; // partial word, zero-padded
+				std::memcpy(&w, tail, filled);
+				return (state ^ w ^ (uint64_t(filled) << 56)) * prime;
+			}
+
+		private:
+			static constexpr uint64_t prime = 1099511628211ull; // FNV-1a 64-bit prime
+
+			void fold(uint64_t w) { state = (state ^ w) * prime; }
+
+			void push(unsigned char b) {
+
+				tail[filled++] = b;
+
+				if (filled == 8) {
+					uint64_t w;
+					std::memcpy(&w, tail, 8);
+					fold(w);
+					filled = 0;
+				}
+			}
+
+			uint64_t state = 14695981039346656037ull; // FNV-1a 64-bit offset basis
+			unsigned char tail[8] = {}; // bytes of an unfinished word
+			size_t filled = 0; // bytes in tail
+		};
+
+		// write bytes and fold them into the checksum
+		inline void writeBytes(std::ostream& out, const void* data, size_t n, file_checksum& sum) {
+
+			sum.update(data, n);
+			out.write(static_cast<const char*>(data), static_cast<std::streamsize>(n));
+
+			if (!out) {
+				throw std::runtime_error("bst_file: write failed");
+			}
+		}
+
+		// read bytes and fold them into the checksum
+		inline void readBytes(std::istream& in, void* data, size_t n, file_checksum& sum) {
+
+			in.read(static_cast<char*>(data), static_cast<std::streamsize>(n));
+
+			if (static_cast<size_t>(in.gcount()) != n) {
+				throw std::runtime_error("bst_file: truncated file");
+			}
+
+			sum.update(data, n);
+		}
+
+		// check the magic, version and element size of a header
+		template <typename T>
+		void checkHeader(const file_header& h) {
+
+			if (std::memcmp(h.magic, file_magic, sizeof(file_magic)) != 0) {
+				throw std::runtime_error("bst_file: not a bst file");
+			}
+
+			if (h.version != file_version) {
+				throw std::runtime_error("bst_file: unsupported version or byte order");
+			}
+
+			if (h.element_size != codec<T>::fixed_size) {
+				throw std::runtime_error("bst_file: element size does not match the codec");
+			}
+		}
+	}
+
+	/**
+	* writes the elements of a tree in order, with a header and a checksum
+	* @param tree the tree to write
+	* @param out binary stream to write to
+	*/
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	void save(const bst<T, compare_type, balance_type, alloc_type, options>& tree, std::ostream& out) {
+
+		detail::file_checksum sum; // of everything before the trailer
+		detail::file_header h = {}; // zeroed, padding included, so the checksum is stable
+
+		std::memcpy(h.magic, detail::file_magic, sizeof(h.magic));
+		h.version = detail::file_version;
+		h.element_size = codec<T>::fixed_size;
+		h.count = tree.size();
+
+		detail::writeBytes(out, &h, sizeof(h), sum);
+
+		std::string buffer; // encoded elements not yet written
+		buffer.reserve(detail::file_block + 64);
+
+		// bitwise payloads are one unframed run; others go in length-prefixed blocks
+		auto flush = [&] {
+
+			if constexpr (!codec<T>::bitwise) {
+				uint32_t length = static_cast<uint32_t>(buffer.size());
+				detail::writeBytes(out, &length, sizeof(length), sum);
+			}
+
+			detail::writeBytes(out, buffer.data(), buffer.size(), sum);
+			buffer.clear();
+		};
+
+		for (const T& value : tree) {
+
+			codec<T>::encode(value, buffer);
+
+			if (buffer.size() >= detail::file_block) {
+				flush();
+			}
+		}
+
+		if (!buffer.empty()) {
+			flush();
+		}
+
+		if constexpr (!codec<T>::bitwise) { // end of the blocks
+			flush();
+		}
+
+		uint64_t checksum = sum.value(); // covers the header and the payload
+		out.write(reinterpret_cast<const char*>(&checksum), sizeof(checksum));
+
+		if (!out.flush()) {
+			throw std::runtime_error("bst_file: write failed");
+		}
+	}
+
+	/**
+	* writes the elements of a tree in order to a file, replacing it
+	* @param tree the tree to write
+	* @param path file to create or truncate
+	*/
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	void save(const bst<T, compare_type, balance_type, alloc_type, options>& tree, const std::string& path) {
+
+		std::ofstream out(path, std::ios::binary | std::ios::trunc);
+
+		if (!out) {
+			throw std::runtime_error("bst_file: cannot create " + path);
+		}
+
+		save(tree, out);
+	}
+
+	/**
+	* replaces the contents of a tree with the elements written by save,
+	* linking them in O(n) after checking the checksum and that they are
+	* sorted under the tree's comparator; the tree is unchanged on failure
+	* @param tree the tree to fill
+	* @param in binary stream positioned at the start of the file
+	* @throws std::runtime_error if the file is malformed or corrupted
+	*/
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	void load(bst<T, compare_type, balance_type, alloc_type, options>& tree, std::istream& in) {
+
+		detail::file_checksum sum; // of everything before the trailer
+		detail::file_header h; // as read
+
+		detail::readBytes(in, &h, sizeof(h), sum);
+		detail::checkHeader<T>(h);
+
+		std::vector<T> values; // decoded elements, in file order
+
+		if constexpr (codec<T>::bitwise) { // read straight into place, a block at a time
+
+			if (h.count > SIZE_MAX / sizeof(T)) {
+				throw std::runtime_error("bst_file: element count too large");
+			}
+
+			// the header count is untrusted, so grow only as the payload arrives
+			const size_t per_block = std::max<size_t>(detail::file_block / sizeof(T), 1);
+			values.reserve(static_cast<size_t>(std::min<uint64_t>(h.count, per_block)));
+
+			while (values.size() != h.count) {
+
+				size_t filled = values.size();
+				size_t n = static_cast<size_t>(std::min<uint64_t>(h.count - filled, per_block));
+
+				values.resize(filled + n);
+				detail::readBytes(in, values.data() + filled, n * sizeof(T), sum);
+			}
+		}
+		else { // decode block by block
+
+			std::vector<char> block; // one block's bytes
+			values.reserve(static_cast<size_t>(std::min<uint64_t>(h.count, detail::file_block)));
+
+			for (;;) {
+
+				uint32_t length; // bytes in the next block (0 at the end)
+				detail::readBytes(in, &length, sizeof(length), sum);
+
+				if (!length) {
+					break;
+				}
+
+				block.resize(length);
+				detail::readBytes(in, block.data(), length, sum);
+
+				for (const char* p = block.data(); p != block.data() + length; ) {
+					values.push_back(codec<T>::decode(p, block.data() + length));
+				}
+			}
+
+			if (values.size() != h.count) {
+				throw std::runtime_error("bst_file: element count does not match the header");
+			}
+		}
+
+		uint64_t checksum; // as written by save
+		in.read(reinterpret_cast<char*>(&checksum), sizeof(checksum));
+
+		if (in.gcount() != sizeof(checksum) || checksum != sum.value()) {
+			throw std::runtime_error("bst_file: checksum mismatch");
+		}
+
+		// a file saved under another ordering would make a broken tree
+		compare_type pred = tree.key_comp();
+		auto not_before = [&pred](const T& a, const T& b) { return !pred(a, b); };
+
+		if (std::adjacent_find(values.begin(), values.end(), not_before) != values.end()) {
+			throw std::runtime_error("bst_file: elements not sorted under this comparator");
+		}
+
+		tree.assign(sorted_unique, std::make_move_iterator(values.begin()), std::make_move_iterator(values.end()));
+	}
+
+	/**
+	* replaces the contents of a tree with the elements of a file written by save
+	* @param tree the tree to fill
+	* @param path file to read
+	* @throws std::runtime_error if the file is missing, malformed or corrupted
+	*/
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	void load(bst<T, compare_type, balance_type, alloc_type, options>& tree, const std::string& path) {
+
+		std::ifstream in(path, std::ios::binary);
+
+		if (!in) {
+			throw std::runtime_error("bst_file: cannot open " + path);
+		}
+
+		load(tree, in);
+	}
+
+	/**
+	* read-only sorted set served from a file written by save, without
+	* deserializing: the file is mapped (read into memory where mmap is not
+	* available) and searched in place by binary search over its payload,
+	* so opening costs O(1) and only the pages a search touches are read
+	* T must have a bitwise codec (trivially copyable with the default codec)
+	* @param T the data type of the file
+	* @param compare_type the comparison function the file was sorted by
+	*/
+	template <typename T, typename compare_type = std::less<T>>
+	class mapped_bst {
+
+		static_assert(codec<T>::bitwise, "mapped_bst needs a bitwise codec for T");
+
+	public:
+
+		/**
+		* random access, read-only
+		*/
+		using iterator = const T*;
+
+		/**
+		* constructor which maps a file and checks its header and size
+		* @param path file written by save
+		* @param pred_input the comparison function the file was sorted by
+		* @param verify also check the checksum and the order, reading every page
+		* @throws std::runtime_error if the file is missing, malformed or corrupted
+		*/
+		explicit mapped_bst(const std::string& path, const compare_type& pred_input = compare_type(),
+			bool verify = false);
+
+		/**
+		* destructor which unmaps the file
+		*/
+		~mapped_bst();
+
+		mapped_bst(const mapped_bst&) = delete;
+
+		/**
+		* move constructor
+		* @param that rvalue reference to move-from mapping, left empty
+		*/
+		mapped_bst(mapped_bst&& that) noexcept;
+
+		/**
+		* move assignment operator
+		* @param that move-from mapping
+		*/
+		mapped_bst& operator=(mapped_bst that) &;
+
+		/**
+		* checks if the file contains a particular element
+		* @param item the type T element to look for
+		* @return iterator to the element
+		*/
+		iterator find(const T& item) const;
+
+		/**
+		* checks if the file contains an element equivalent to key
+		* (only with a transparent comparator)
+		* @param key value comparable with T through compare_type
+		* @return iterator to the element
+		*/
+		template <typename K, typename C = compare_type,
+			typename = std::enable_if_t<detail::is_transparent<C>::value>>
+		iterator find(const K& key) const;
+
+		/**
+		* counts elements equivalent to a value
+		* @param item the type T element to look for
+		* @return 1 if present, 0 otherwise
+		*/
+		size_t count(const T& item) const { return find(item) != end() ? 1 : 0; }
+
+		/**
+		* checks if the file contains a particular element
+		* @param item the type T element to look for
+		* @return whether an equivalent element is present
+		*/
+		bool contains(const T& item) const { return find(item) != end(); }
+
+		/**
+		* first element not less than a value
+		* @param item the type T bound
+		* @return iterator to that element, or end()
+		*/
+		iterator lower_bound(const T& item) const { return std::lower_bound(first, first + tree_size, item, pred); }
+
+		/**
+		* first element greater than a value
+		* @param item the type T bound
+		* @return iterator to that element, or end()
+		*/
+		iterator upper_bound(const T& item) const { return std::upper_bound(first, first + tree_size, item, pred); }
+
+		/**
+		* swaps two mappings
+		* @param other mapping to swap the implicit "this" mapping with
+		*/
+		void swap(mapped_bst& other);
+
+		/**
+		* returns an iterator to the "smallest" element
+		* @return pointer to the first element of the payload
+		*/
+		iterator begin() const { return first; }
+
+		/**
+		* returns an iterator to past-the-end position
+		* @return pointer past the last element of the payload
+		*/
+		iterator end() const { return first + tree_size; }
+
+		/**
+		* accessor to the number of elements
+		* @return number of elements
+		*/
+		size_t size() const { return tree_size; }
+
+	private:
+		compare_type pred; // comparison function the file was sorted by
+		char* region; // the mapped (or read) file
+		size_t region_bytes; // its length
+		const T* first; // first element of the payload
+		size_t tree_size; // number of elements
+
+		// element equivalent to key, or end()
+		template <typename K>
+		iterator findKey(const K&) const;
+
+		void unmap(); // give the region back
+	};
+
+	// map the file, then check it
+	template <typename T, typename compare_type>
+	mapped_bst<T, compare_type>::mapped_bst(const std::string& path, const compare_type& pred_input, bool verify) :
+		pred(pred_input), region(nullptr), region_bytes(0), first(nullptr), tree_size(0) {
+
+#ifdef BST_FILE_MMAP
+		int fd = ::open(path.c_str(), O_RDONLY);
+
+		if (fd < 0) {
+			throw std::runtime_error("bst_file: cannot open " + path);
+		}
+
+		struct stat st;
+
+		if (::fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(detail::file_header))) {
+			::close(fd);
+			throw std::runtime_error("bst_file: truncated file");
+		}
+
+		region_bytes = static_cast<size_t>(st.st_size);
+		void* p = ::mmap(nullptr, region_bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+		::close(fd); // the mapping keeps the file open
+
+		if (p == MAP_FAILED) {
+			region_bytes = 0;
+			throw std::runtime_error("bst_file: cannot map " + path);
+		}
+
+		region = static_cast<char*>(p);
+#else
+		std::ifstream in(path, std::ios::binary | std::ios::ate);
+
+		if (!in) {
+			throw std::runtime_error("bst_file: cannot open " + path);
+		}
+
+		region_bytes = static_cast<size_t>(in.tellg());
+		region = new char[region_bytes]; // aligned for any fundamental type
+		in.seekg(0);
+
+		if (!in.read(region, static_cast<std::streamsize>(region_bytes))) {
+			unmap();
+			throw std::runtime_error("bst_file: truncated file");
+		}
+#endif
+
+		try {
+			detail::file_header h; // copied out, the region is only byte-aligned in theory
+
+			if (region_bytes < sizeof(h)) {
+				throw std::runtime_error("bst_file: truncated file");
+			}
+
+			std::memcpy(&h, region, sizeof(h));
+			detail::checkHeader<T>(h);
+
+			if (h.count > (region_bytes - sizeof(h) - sizeof(uint64_t)) / sizeof(T) ||
+				region_bytes != sizeof(h) + h.count * sizeof(T) + sizeof(uint64_t)) {
+				throw std::runtime_error("bst_file: file size does not match the header");
+			}
+
+			first = reinterpret_cast<const T*>(region + sizeof(h));
+			tree_size = static_cast<size_t>(h.count);
+
+			if (verify) {
+
+				detail::file_checksum sum; // of everything before the trailer
+				sum.update(region, region_bytes - sizeof(uint64_t));
+
+				uint64_t checksum; // as written by save
+				std::memcpy(&checksum, region + region_bytes - sizeof(uint64_t), sizeof(checksum));
+
+				if (checksum != sum.value()) {
+					throw std::runtime_error("bst_file: checksum mismatch");
+				}
+
+				auto not_before = [this](const T& a, const T& b) { return !pred(a, b); };
+
+				if (std::adjacent_find(begin(), end(), not_before) != end()) {
+					throw std::runtime_error("bst_file: elements not sorted under this comparator");
+				}
+			}
+		}
+		catch (...) { // the destructor will not run
+			unmap();
+			throw;
+		}
+	}
+
+	// give the region back
+	template <typename T, typename compare_type>
+	mapped_bst<T, compare_type>::~mapped_bst() {
+		unmap();
+	}
+
+	// move constructor
+	template <typename T, typename compare_type>
+	mapped_bst<T, compare_type>::mapped_bst(mapped_bst&& that) noexcept :
+		pred(that.pred), region(that.region), region_bytes(that.region_bytes), first(that.first), tree_size(that.tree_size) {
+
+		that.region = nullptr;
+		that.region_bytes = 0;
+		that.first = nullptr;
+		that.tree_size = 0;
+	}
+
+	// move assignment operator
+	template <typename T, typename compare_type>
+	mapped_bst<T, compare_type>& mapped_bst<T, compare_type>::operator=(mapped_bst that) & {
+
+		swap(that);
+		return *this;
+	}
+
+	// find by value
+	template <typename T, typename compare_type>
+	typename mapped_bst<T, compare_type>::iterator mapped_bst<T, compare_type>::find(const T& item) const {
+		return findKey(item);
+	}
+
+	// find by key
+	template <typename T, typename compare_type>
+	template <typename K, typename C, typename>
+	typename mapped_bst<T, compare_type>::iterator mapped_bst<T, compare_type>::find(const K& key) const {
+		return findKey(key);
+	}
+
+	// swap every member
+	template <typename T, typename compare_type>
+	void mapped_bst<T, compare_type>::swap(mapped_bst& other) {
+
+		using std::swap;
+		swap(pred, other.pred);
+		swap(region, other.region);
+		swap(region_bytes, other.region_bytes);
+		swap(first, other.first);
+		swap(tree_size, other.tree_size);
+	}
+
+	// binary search over the payload
+	template <typename T, typename compare_type>
+	template <typename K>
+	typename mapped_bst<T, compare_type>::iterator mapped_bst<T, compare_type>::findKey(const K& key) const {
+
+		// first element not less than key
+		iterator it = std::lower_bound(first, first + tree_size, key,
+			[this](const T& value, const K& k) { return pred(value, k); });
+
+		// equivalent if key is not less than it either
+		return it != end() && !pred(key, *it) ? it : end();
+	}
+
+	// unmap, or free the copy
+	template <typename T, typename compare_type>
+	void mapped_bst<T, compare_type>::unmap() {
+
+		if (region) {
+#ifdef BST_FILE_MMAP
+			::munmap(region, region_bytes);
+#else
+			delete[] region;
+#endif
+		}
+
+		region = nullptr;
+		region_bytes = 0;
+	}
+}
+
+#endif
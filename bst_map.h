@@ -0,0 +1,614 @@
+#ifndef BST_MAP_H
+#define BST_MAP_H
+
+#include <utility>
+#include <functional>
+#include <stdexcept>
+#include <tuple>
+#include <iterator>
+#include <type_traits>
+#include <cstddef>
+#include <memory>
+
+#include "bst.h"
+
+namespace binarysearch {
+
+	/**
+	* templated key-value map built on bst nodes
+	* each element is a std::pair<const K, V> kept in key order; the key is
+	* fixed once inserted but the mapped value can be changed in place through
+	* iterators, operator[] and at, so updating an existing entry takes one
+	* descent and no allocation
+	* @param K the key type
+	* @param V the mapped type
+	* @param compare_type the comparison function to compare the keys
+	* @param balance_type the balancing policy (red_black or unbalanced)
+	* @param alloc_type the allocator, rebound internally to the node type
+	*/
+	template <typename K, typename V, typename compare_type = std::less<K>, typename balance_type = red_black,
+		typename alloc_type = std::allocator<std::pair<const K, V>>>
+	class bst_map {
+
+	public:
+
+		using key_type = K;
+		using mapped_type = V;
+		using value_type = std::pair<const K, V>;
+
+		/**
+		* orders elements by key through compare_type; transparent, so the
+		* underlying tree can be searched with a bare key
+		*/
+		class value_compare {
+
+			friend bst_map; //to allow construction from the key comparator
+
+		public:
+
+			using is_transparent = void;
+
+			/**
+			* compares two elements or keys by key
+			* @param left element or key
+			* @param right element or key
+			* @return if the key of left < the key of right
+			*/
+			template <typename A, typename B>
+			bool operator()(const A& left, const B& right) const {
+				return comp(key(left), key(right));
+			}
+
+		private:
+
+			/**
+			* constructor which initializes comp
+			* @param comp_input the key comparator
+			*/
+			value_compare(const compare_type& comp_input) : comp(comp_input) {}
+
+			static const K& key(const value_type& v) { return v.first; } // key of an element
+
+			template <typename Q>
+			static const Q& key(const Q& q) { return q; } // a key as it is
+
+			compare_type comp; // the key comparator
+		};
+
+	private:
+
+		using tree_type = bst<value_type, value_compare, balance_type, alloc_type>;
+
+	public:
+
+		/**
+		* read-only iterator, as for bst
+		*/
+		using const_iterator = typename tree_type::iterator;
+
+		/**
+		* iterator class declaration
+		*/
+		class iterator;
+
+		/**
+		* constructor which initializes tree
+		* @param comp_input the comparison function to compare the keys
+		* @param alloc_input the allocator used for the nodes
+		*/
+		bst_map(const compare_type& comp_input = compare_type(),
+			const alloc_type& alloc_input = alloc_type()) :
+			tree(value_compare(comp_input), alloc_input) {}
+
+		/**
+		* constructor which initializes tree
+		* @param alloc_input the allocator used for the nodes
+		*/
+		explicit bst_map(const alloc_type& alloc_input) :
+			bst_map(compare_type(), alloc_input) {}
+
+		/**
+		* range constructor; of several elements with equivalent keys the
+		* first one is kept, and keys in ascending order take O(1) comparisons
+		* each but O(log n) steps down the right spine, so an already sorted
+		* range of unique keys builds faster through the sorted_unique constructor
+		* @param first beginning of the range
+		* @param last end of the range
+		* @param comp_input the comparison function to compare the keys
+		* @param alloc_input the allocator used for the nodes
+		*/
+		template <typename InputIt, typename = typename std::iterator_traits<InputIt>::iterator_category>
+		bst_map(InputIt first, InputIt last, const compare_type& comp_input = compare_type(),
+			const alloc_type& alloc_input = alloc_type());
+
+		/**
+		* range constructor which builds a balanced tree in O(n) from a
+		* range the caller guarantees sorted by key and free of equivalents
+		* @param first beginning of the range
+		* @param last end of the range
+		* @param comp_input the comparison function to compare the keys
+		* @param alloc_input the allocator used for the nodes
+		*/
+		template <typename InputIt, typename = typename std::iterator_traits<InputIt>::iterator_category>
+		bst_map(sorted_unique_t, InputIt first, InputIt last, const compare_type& comp_input = compare_type(),
+			const alloc_type& alloc_input = alloc_type()) :
+			bst_map(comp_input, alloc_input) { tree.assign(sorted_unique, first, last); }
+
+		/**
+		* element with a key equivalent to key
+		* @param key the key to look for
+		* @return iterator to the element, or end()
+		*/
+		iterator find(const K& key);
+
+		/**
+		* element with a key equivalent to key
+		* @param key the key to look for
+		* @return read-only iterator to the element, or end()
+		*/
+		const_iterator find(const K& key) const { return tree.find(key); }
+
+		/**
+		* element with a key equivalent to key, without constructing a K
+		* (only with a transparent comparator)
+		* @param key value comparable with K through compare_type
+		* @return iterator to the element, or end()
+		*/
+		template <typename Q, typename C = compare_type,
+			typename = std::enable_if_t<detail::is_transparent<C>::value>>
+		iterator find(const Q& key);
+
+		/**
+		* element with a key equivalent to key, without constructing a K
+		* (only with a transparent comparator)
+		* @param key value comparable with K through compare_type
+		* @return read-only iterator to the element, or end()
+		*/
+		template <typename Q, typename C = compare_type,
+			typename = std::enable_if_t<detail::is_transparent<C>::value>>
+		const_iterator find(const Q& key) const { return tree.find(key); }
+
+		/**
+		* counts elements with a key equivalent to key
+		* @param key the key to look for
+		* @return 1 if present, 0 otherwise
+		*/
+		size_t count(const K& key) const { return tree.count(key); }
+
+		/**
+		* checks if an element with a key equivalent to key is present
+		* @param key the key to look for
+		* @return whether such an element is present
+		*/
+		bool contains(const K& key) const { return tree.contains(key); }
+
+		/**
+		* checks if an element with a key equivalent to key is present,
+		* without constructing a K (only with a transparent comparator)
+		* @param key value comparable with K through compare_type
+		* @return whether such an element is present
+		*/
+		template <typename Q, typename C = compare_type,
+			typename = std::enable_if_t<detail::is_transparent<C>::value>>
+		bool contains(const Q& key) const { return tree.contains(key); }
+
+		/**
+		* first element whose key is not less than key
+		* @param key the bound
+		* @return iterator to that element, or end()
+		*/
+		iterator lower_bound(const K& key) { return iterator(tree.lower_bound(key)); }
+
+		/**
+		* first element whose key is not less than key
+		* @param key the bound
+		* @return read-only iterator to that element, or end()
+		*/
+		const_iterator lower_bound(const K& key) const { return tree.lower_bound(key); }
+
+		/**
+		* first element whose key is greater than key
+		* @param key the bound
+		* @return iterator to that element, or end()
+		*/
+		iterator upper_bound(const K& key) { return iterator(tree.upper_bound(key)); }
+
+		/**
+		* first element whose key is greater than key
+		* @param key the bound
+		* @return read-only iterator to that element, or end()
+		*/
+		const_iterator upper_bound(const K& key) const { return tree.upper_bound(key); }
+
+		/**
+		* the mapped value of the element with a key equivalent to key,
+		* inserting a value-initialized V first if there is none
+		* @param key the key to look for, copied only on a miss
+		* @return reference to the mapped value
+		*/
+		V& operator[](const K& key);
+
+		/**
+		* the mapped value of the element with a key equivalent to key,
+		* inserting a value-initialized V first if there is none
+		* @param key the key to look for, moved from only on a miss
+		* @return reference to the mapped value
+		*/
+		V& operator[](K&& key);
+
+		/**
+		* the mapped value of the element with a key equivalent to key
+		* @param key the key to look for
+		* @return reference to the mapped value
+		* @throws std::out_of_range if no element has an equivalent key
+		*/
+		V& at(const K& key);
+
+		/**
+		* the mapped value of the element with a key equivalent to key
+		* @param key the key to look for
+		* @return reference to the mapped value
+		* @throws std::out_of_range if no element has an equivalent key
+		*/
+		const V& at(const K& key) const;
+
+		/**
+		* adds a copy of an element unless its key is already present
+		* @param value the element to be added
+		* @return iterator to the element with an equivalent key and
+		* whether value was inserted (false if the key was already present)
+		*/
+		std::pair<iterator, bool> insert(const value_type& value);
+
+		/**
+		* adds an element unless its key is already present
+		* @param value the element to be added
+		* @return iterator to the element with an equivalent key and
+		* whether value was inserted (false if the key was already present)
+		*/
+		std::pair<iterator, bool> insert(value_type&& value);
+
+		/**
+		* constructs an element from args, once, in its node, and links it
+		* unless its key is already present
+		* @param args variadic list of arguments used to construct value_type
+		* @return iterator to the element with an equivalent key and
+		* whether the new element was inserted
+		*/
+		template <typename... Types>
+		std::pair<iterator, bool> emplace(Types&&... args);
+
+		/**
+		* searches for key first and, only if it is absent, constructs the
+		* element from key and V(args...) directly in a new node
+		* @param key the key of the element, forwarded only on a miss
+		* @param args arguments forwarded to V's constructor
+		* @return iterator to the element with an equivalent key and
+		* whether the new element was inserted
+		*/
+		template <typename KK, typename... Types>
+		std::pair<iterator, bool> try_emplace(KK&& key, Types&&... args);
+
+		/**
+		* assigns obj to the mapped value of the element with a key
+		* equivalent to key, or inserts (key, obj) if there is none
+		* @param key the key of the element, forwarded only on a miss
+		* @param obj the value to assign or insert
+		* @return iterator to the element and whether it was inserted
+		*/
+		template <typename KK, typename M>
+		std::pair<iterator, bool> insert_or_assign(KK&& key, M&& obj);
+
+		/**
+		* removes an element
+		* @param bad iterator to the element to remove
+		*/
+		void erase(iterator bad) { tree.erase(bad.it); }
+
+		/**
+		* removes the element with a key equivalent to key, if any
+		* @param key the key of the element to remove
+		* @return number of elements removed (0 or 1)
+		*/
+		size_t erase(const K& key);
+
+		/**
+		* swaps two maps
+		* @param other map to swap the implicit "this" map with
+		*/
+		void swap(bst_map& other) { tree.swap(other.tree); }
+
+		/**
+		* returns an iterator to the element with the smallest key
+		* @return iterator to the first element
+		*/
+		iterator begin() { return iterator(tree.begin()); }
+
+		/**
+		* returns a read-only iterator to the element with the smallest key
+		* @return iterator to the first element
+		*/
+		const_iterator begin() const { return tree.begin(); }
+
+		/**
+		* returns an iterator to past-the-end position
+		* @return iterator to nullptr
+		*/
+		iterator end() { return iterator(tree.end()); }
+
+		/**
+		* returns a read-only iterator to past-the-end position
+		* @return iterator to nullptr
+		*/
+		const_iterator end() const { return tree.end(); }
+
+		/**
+		* accessor to the number of elements
+		* @return number of elements
+		*/
+		size_t size() const { return tree.size(); }
+
+		/**
+		* removes every element, keeping the comparator and allocator
+		*/
+		void clear() { tree.clear(); }
+
+		/**
+		* accessor to a copy of the key comparator
+		* @return the comparison function to compare the keys
+		*/
+		compare_type key_comp() const { return tree.pred.comp; }
+
+		/**
+		* accessor to a copy of the element comparator
+		* @return comparison function ordering elements by key
+		*/
+		value_compare value_comp() const { return tree.pred; }
+
+		/**
+		* accessor to a copy of the allocator
+		* @return the allocator, rebound to value_type
+		*/
+		alloc_type get_allocator() const { return tree.get_allocator(); }
+
+	private:
+		tree_type tree; // elements ordered by key
+
+		// mapped value at the element with key, inserted from key and V(args...) if absent
+		template <typename KK, typename... Types>
+		std::pair<iterator, bool> emplaceMapped(KK&&, Types&&...);
+	};
+
+	//nested iterator class definition
+	template <typename K, typename V, typename compare_type, typename balance_type, typename alloc_type>
+	class bst_map<K, V, compare_type, balance_type, alloc_type>::iterator { //nested iterator class
+
+		friend bst_map; //to allow iterator construction by bst_map operations
+
+		public:
+
+		// standard iterator traits (bidirectional, mapped values writable)
+		using iterator_category = std::bidirectional_iterator_tag;
+		using value_type = std::pair<const K, V>;
+		using difference_type = std::ptrdiff_t;
+		using pointer = value_type*;
+		using reference = value_type&;
+
+		/**
+		* default constructor, a singular iterator that may only be assigned
+		* to or compared with other default-constructed iterators
+		*/
+		iterator() = default;
+
+		/**
+		* overloaded prefix ++
+		*/
+		iterator& operator++() {
+			++it;
+			return *this;
+		}
+
+		/**
+		* overloaded postfix ++
+		*/
+		iterator operator++(int) {
+			return iterator(it++);
+		}
+
+		/**
+		* overloaded prefix --
+		*/
+		iterator& operator--() {
+			--it;
+			return *this;
+		}
+
+		/**
+		* overloaded postfix --
+		*/
+		iterator operator--(int) {
+			return iterator(it--);
+		}
+
+		/**
+		* overloaded == comparison operator
+		*/
+		friend bool operator==(const iterator& left, const iterator& right) {
+			return left.it == right.it;
+		}
+
+		/**
+		* overloaded != comparison operator
+		*/
+		friend bool operator!=(const iterator& left, const iterator& right) {
+			return left.it != right.it;
+		}
+
+		/**
+		* overload dereferencing operator (the key stays const)
+		*/
+		value_type& operator*() const {
+
+			// nodes hold non-const pairs, only the tree's iterator adds const
+			return const_cast<value_type&>(*it);
+		}
+
+		/**
+		* overload the operator arrow (the key stays const)
+		*/
+		value_type* operator->() const {
+			return &**this;
+		}
+
+		/**
+		* converts to the read-only iterator at the same element
+		*/
+		operator const_iterator() const {
+			return it;
+		}
+
+	private:
+
+		/**
+		* constructor which initializes it
+		* @param i the tree iterator at the element
+		*/
+		explicit iterator(const_iterator i) : it(i) {}
+
+		const_iterator it; // position in the underlying tree
+	};
+
+	// range constructor: hinted inserts, O(1) comparisons but O(log n) each while keys ascend
+	template <typename K, typename V, typename compare_type, typename balance_type, typename alloc_type>
+	template <typename InputIt, typename>
+	bst_map<K, V, compare_type, balance_type, alloc_type>::bst_map(InputIt first, InputIt last,
+		const compare_type& comp_input, const alloc_type& alloc_input) :
+		bst_map(comp_input, alloc_input) {
+
+		// pair<const K, V> cannot be sorted in a buffer as bst::assign would
+		for (; first != last; ++first) {
+			tree.emplace_hint(tree.end(), *first);
+		}
+	}
+
+	// element with an equivalent key, writable
+	template <typename K, typename V, typename compare_type, typename balance_type, typename alloc_type>
+	typename bst_map<K, V, compare_type, balance_type, alloc_type>::iterator
+		bst_map<K, V, compare_type, balance_type, alloc_type>::find(const K& key) {
+		return iterator(tree.find(key));
+	}
+
+	// element with an equivalent key, writable, searched with another key type
+	template <typename K, typename V, typename compare_type, typename balance_type, typename alloc_type>
+	template <typename Q, typename C, typename>
+	typename bst_map<K, V, compare_type, balance_type, alloc_type>::iterator
+		bst_map<K, V, compare_type, balance_type, alloc_type>::find(const Q& key) {
+		return iterator(tree.find(key));
+	}
+
+	// mapped value, default-inserted on a miss (key copied)
+	template <typename K, typename V, typename compare_type, typename balance_type, typename alloc_type>
+	V& bst_map<K, V, compare_type, balance_type, alloc_type>::operator[](const K& key) {
+		return emplaceMapped(key).first->second;
+	}
+
+	// mapped value, default-inserted on a miss (key moved)
+	template <typename K, typename V, typename compare_type, typename balance_type, typename alloc_type>
+	V& bst_map<K, V, compare_type, balance_type, alloc_type>::operator[](K&& key) {
+		return emplaceMapped(std::move(key)).first->second;
+	}
+
+	// mapped value of an existing element
+	template <typename K, typename V, typename compare_type, typename balance_type, typename alloc_type>
+	V& bst_map<K, V, compare_type, balance_type, alloc_type>::at(const K& key) {
+		return const_cast<V&>(static_cast<const bst_map&>(*this).at(key));
+	}
+
+	// mapped value of an existing element, read-only
+	template <typename K, typename V, typename compare_type, typename balance_type, typename alloc_type>
+	const V& bst_map<K, V, compare_type, balance_type, alloc_type>::at(const K& key) const {
+
+		const_iterator it = tree.find(key); // element with an equivalent key
+
+		if (it == tree.end()) {
+			throw std::out_of_range("bst_map::at: key not found");
+		}
+
+		return it->second;
+	}
+
+	// to add an element (lvalue)
+	template <typename K, typename V, typename compare_type, typename balance_type, typename alloc_type>
+	std::pair<typename bst_map<K, V, compare_type, balance_type, alloc_type>::iterator, bool>
+		bst_map<K, V, compare_type, balance_type, alloc_type>::insert(const value_type& val) {
+
+		// searched by key, copied only on a miss
+		auto result = tree.emplaceKey(val.first, val);
+		return { iterator(result.first), result.second };
+	}
+
+	// to add an element (rvalue)
+	template <typename K, typename V, typename compare_type, typename balance_type, typename alloc_type>
+	std::pair<typename bst_map<K, V, compare_type, balance_type, alloc_type>::iterator, bool>
+		bst_map<K, V, compare_type, balance_type, alloc_type>::insert(value_type&& val) {
+
+		// searched by key, moved only on a miss
+		auto result = tree.emplaceKey(val.first, std::move(val));
+		return { iterator(result.first), result.second };
+	}
+
+	// construct an element in its node and attempt to link it
+	template <typename K, typename V, typename compare_type, typename balance_type, typename alloc_type>
+	template <typename... Types>
+	std::pair<typename bst_map<K, V, compare_type, balance_type, alloc_type>::iterator, bool>
+		bst_map<K, V, compare_type, balance_type, alloc_type>::emplace(Types&&... args) {
+
+		auto result = tree.emplace(std::forward<Types>(args)...);
+		return { iterator(result.first), result.second };
+	}
+
+	// search with the key, construct only on a miss
+	template <typename K, typename V, typename compare_type, typename balance_type, typename alloc_type>
+	template <typename KK, typename... Types>
+	std::pair<typename bst_map<K, V, compare_type, balance_type, alloc_type>::iterator, bool>
+		bst_map<K, V, compare_type, balance_type, alloc_type>::try_emplace(KK&& key, Types&&... args) {
+		return emplaceMapped(std::forward<KK>(key), std::forward<Types>(args)...);
+	}
+
+	// assign to the mapped value in place, or insert on a miss
+	template <typename K, typename V, typename compare_type, typename balance_type, typename alloc_type>
+	template <typename KK, typename M>
+	std::pair<typename bst_map<K, V, compare_type, balance_type, alloc_type>::iterator, bool>
+		bst_map<K, V, compare_type, balance_type, alloc_type>::insert_or_assign(KK&& key, M&& obj) {
+
+		// obj is only read by one of the two branches, so forwarding it twice is safe
+		auto result = emplaceMapped(std::forward<KK>(key), std::forward<M>(obj));
+
+		if (!result.second) { // key present: one descent, no allocation
+			result.first->second = std::forward<M>(obj);
+		}
+
+		return result;
+	}
+
+	// remove the element with an equivalent key
+	template <typename K, typename V, typename compare_type, typename balance_type, typename alloc_type>
+	size_t bst_map<K, V, compare_type, balance_type, alloc_type>::erase(const K& key) {
+		return tree.erase(key);
+	}
+
+	// one descent with key; (key, V(args...)) is built in a new node only on a miss
+	template <typename K, typename V, typename compare_type, typename balance_type, typename alloc_type>
+	template <typename KK, typename... Types>
+	std::pair<typename bst_map<K, V, compare_type, balance_type, alloc_type>::iterator, bool>
+		bst_map<K, V, compare_type, balance_type, alloc_type>::emplaceMapped(KK&& key, Types&&... args) {
+
+		// key is read by the search before it is forwarded to the node
+		auto result = tree.emplaceKey(key, std::piecewise_construct,
+			std::forward_as_tuple(std::forward<KK>(key)), std::forward_as_tuple(std::forward<Types>(args)...));
+
+		return { iterator(result.first), result.second };
+	}
+}
+
+#endif
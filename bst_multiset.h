@@ -0,0 +1,493 @@
+#ifndef BST_MULTISET_H
+#define BST_MULTISET_H
+
+#include <utility>
+#include <functional>
+#include <iterator>
+#include <type_traits>
+#include <cstddef>
+#include <memory>
+
+#include "bst_map.h"
+
+namespace binarysearch {
+
+	/**
+	* templated multiset built on bst_map
+	* equivalent elements share one node holding the first of them and a
+	* count, so n inserts over d distinct keys take d nodes and O(log d) per
+	* operation; later equivalents are counted, not stored, so equivalent
+	* elements must be interchangeable
+	* @param T the data type of the multiset
+	* @param compare_type the comparison function to compare the data
+	* @param balance_type the balancing policy (red_black or unbalanced)
+	* @param alloc_type the allocator, rebound internally to the node type
+	*/
+	template <typename T, typename compare_type = std::less<T>, typename balance_type = red_black,
+		typename alloc_type = std::allocator<T>>
+	class bst_multiset {
+
+		// one entry per distinct element: the element and its multiplicity
+		using map_type = bst_map<T, size_t, compare_type, balance_type,
+			typename std::allocator_traits<alloc_type>::template rebind_alloc<std::pair<const T, size_t>>>;
+
+	public:
+
+		/**
+		* constructor which initializes counts and total
+		* @param pred_input the comparison function to compare the data
+		* @param alloc_input the allocator used for the nodes
+		*/
+		bst_multiset(const compare_type& pred_input = compare_type(),
+			const alloc_type& alloc_input = alloc_type()) :
+			counts(pred_input, alloc_input), total(0) {}
+
+		/**
+		* range constructor keeping every element of the range
+		* @param first beginning of the range
+		* @param last end of the range
+		* @param pred_input the comparison function to compare the data
+		* @param alloc_input the allocator used for the nodes
+		*/
+		template <typename InputIt, typename = typename std::iterator_traits<InputIt>::iterator_category>
+		bst_multiset(InputIt first, InputIt last, const compare_type& pred_input = compare_type(),
+			const alloc_type& alloc_input = alloc_type()) :
+			bst_multiset(pred_input, alloc_input) {
+
+			for (; first != last; ++first) {
+				insert(*first);
+			}
+		}
+
+		/**
+		* iterator class declaration
+		*/
+		class iterator;
+
+		/**
+		* copy constructor
+		* @param rhs copy-from multiset
+		*/
+		bst_multiset(const bst_multiset& rhs) = default;
+
+		/**
+		* move constructor
+		* @param that rvalue reference to move-from multiset, left empty
+		*/
+		bst_multiset(bst_multiset&& that) noexcept :
+			counts(std::move(that.counts)), total(that.total) { that.total = 0; }
+
+		/**
+		* copy/move assignment operator
+		* @param that copy/move-from multiset
+		*/
+		bst_multiset& operator=(bst_multiset that) & {
+			swap(that);
+			return *this;
+		}
+
+		/**
+		* first occurrence of an element equivalent to item
+		* @param item the type T element to look for
+		* @return iterator to the occurrence, or end()
+		*/
+		iterator find(const T& item) const;
+
+		/**
+		* number of elements equivalent to item, in O(log distinct)
+		* @param item the type T element to look for
+		* @return multiplicity of item
+		*/
+		size_t count(const T& item) const;
+
+		/**
+		* checks if an element equivalent to item is present
+		* @param item the type T element to look for
+		* @return whether an equivalent element is present
+		*/
+		bool contains(const T& item) const { return counts.contains(item); }
+
+		/**
+		* first element not less than item
+		* @param item the type T bound
+		* @return iterator to that element, or end()
+		*/
+		iterator lower_bound(const T& item) const;
+
+		/**
+		* first element greater than item
+		* @param item the type T bound
+		* @return iterator to that element, or end()
+		*/
+		iterator upper_bound(const T& item) const;
+
+		/**
+		* every occurrence of elements equivalent to item
+		* @param item the type T element to look for
+		* @return lower_bound(item) and upper_bound(item)
+		*/
+		std::pair<iterator, iterator> equal_range(const T& item) const;
+
+		/**
+		* adds an occurrence of value; the first of several equivalent
+		* elements is the one stored, later ones only raise its count
+		* @param value the element to be added
+		* @return iterator to the new (last) occurrence
+		*/
+		iterator insert(const T& value) { return insert(value, 1); }
+
+		/**
+		* adds copies occurrences of value in one descent
+		* @param value the element to be added
+		* @param copies number of occurrences to add (0 adds nothing)
+		* @return iterator to the last occurrence, or end() if copies is 0
+		*/
+		iterator insert(const T& value, size_t copies);
+
+		/**
+		* adds an occurrence of value, moving it in only if it is the first
+		* @param value the element to be added
+		* @return iterator to the new (last) occurrence
+		*/
+		iterator insert(T&& value);
+
+		/**
+		* removes one occurrence; equivalent elements are interchangeable, so
+		* the later occurrences of the element shift down one place, and an
+		* iterator to what was the last of them is invalidated
+		* @param bad iterator to the occurrence to remove
+		* @return iterator to the occurrence that followed bad
+		*/
+		iterator erase(iterator bad);
+
+		/**
+		* removes every element equivalent to item
+		* @param item the type T element to remove
+		* @return number of elements removed
+		*/
+		size_t erase(const T& item);
+
+		/**
+		* removes one element equivalent to item, if any
+		* @param item the type T element to remove
+		* @return number of elements removed (0 or 1)
+		*/
+		size_t erase_one(const T& item);
+
+		/**
+		* swaps two multisets
+		* @param other multiset to swap the implicit "this" multiset with
+		*/
+		void swap(bst_multiset& other);
+
+		/**
+		* returns an iterator to the first occurrence of the "smallest" element
+		* @return iterator to the first element
+		*/
+		iterator begin() const;
+
+		/**
+		* returns an iterator to past-the-end position
+		* @return iterator to nullptr
+		*/
+		iterator end() const;
+
+		/**
+		* accessor to the number of elements, counting every occurrence
+		* @return number of elements
+		*/
+		size_t size() const { return total; }
+
+		/**
+		* accessor to the number of distinct elements (nodes)
+		* @return number of distinct elements
+		*/
+		size_t distinct() const { return counts.size(); }
+
+		/**
+		* removes every element, keeping the comparator and allocator
+		*/
+		void clear();
+
+		/**
+		* accessor to a copy of the allocator
+		* @return the allocator, rebound to T
+		*/
+		alloc_type get_allocator() const { return alloc_type(counts.get_allocator()); }
+
+	private:
+		using entry_iterator = typename map_type::iterator;
+
+		mutable map_type counts; // element to multiplicity (mutable: const lookups return iterators erase accepts)
+		size_t total; // number of elements, counting every occurrence
+	};
+
+	//nested iterator class definition
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type>
+	class bst_multiset<T, compare_type, balance_type, alloc_type>::iterator { //nested iterator class
+
+		friend bst_multiset; //to allow iterator construction by bst_multiset operations
+
+		public:
+
+		// standard iterator traits (bidirectional, read-only)
+		using iterator_category = std::bidirectional_iterator_tag;
+		using value_type = T;
+		using difference_type = std::ptrdiff_t;
+		using pointer = const T*;
+		using reference = const T&;
+
+		/**
+		* default constructor, a singular iterator that may only be assigned
+		* to or compared with other default-constructed iterators
+		*/
+		iterator() = default;
+
+		/**
+		* overloaded prefix ++
+		*/
+		iterator& operator++() {
+
+			if (++index >= entry->second) { // past the last occurrence: next entry
+				++entry;
+				index = 0;
+			}
+			return *this;
+		}
+
+		/**
+		* overloaded postfix ++
+		*/
+		iterator operator++(int) {
+
+			auto copy(*this); // copy of current position
+			++*this;
+			return copy;
+		}
+
+		/**
+		* overloaded prefix --
+		*/
+		iterator& operator--() {
+
+			if (index == 0) { // first occurrence: last one of the previous entry
+				--entry;
+				index = entry->second;
+			}
+			--index;
+			return *this;
+		}
+
+		/**
+		* overloaded postfix --
+		*/
+		iterator operator--(int) {
+
+			auto copy(*this); // copy of current position
+			--*this;
+			return copy;
+		}
+
+		/**
+		* overloaded == comparison operator
+		*/
+		friend bool operator==(const iterator& left, const iterator& right) {
+			return left.entry == right.entry && left.index == right.index;
+		}
+
+		/**
+		* overloaded != comparison operator
+		*/
+		friend bool operator!=(const iterator& left, const iterator& right) {
+			return !(left == right);
+		}
+
+		/**
+		* overload dereferencing operator (without modifying tree element)
+		*/
+		const T& operator*() const {
+			return entry->first; // the stored representative
+		}
+
+		/**
+		* overload the operator arrow (without modifying tree element)
+		*/
+		const T* operator->() const {
+			return &entry->first;
+		}
+
+	private:
+
+		/**
+		* constructor which initializes entry and index
+		* @param e the entry of the element
+		* @param i which of its occurrences
+		*/
+		iterator(entry_iterator e, size_t i) : entry(e), index(i) {}
+
+		entry_iterator entry; // element and multiplicity
+		size_t index = 0; // occurrence within the entry (0 at end)
+	};
+
+	// first occurrence of an equivalent element
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type>
+	typename bst_multiset<T, compare_type, balance_type, alloc_type>::iterator
+		bst_multiset<T, compare_type, balance_type, alloc_type>::find(const T& item) const {
+		return iterator(counts.find(item), 0);
+	}
+
+	// multiplicity of an element
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type>
+	size_t bst_multiset<T, compare_type, balance_type, alloc_type>::count(const T& item) const {
+
+		entry_iterator e = counts.find(item); // entry of the element, if any
+		return e == counts.end() ? 0 : e->second;
+	}
+
+	// first element not less than a value
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type>
+	typename bst_multiset<T, compare_type, balance_type, alloc_type>::iterator
+		bst_multiset<T, compare_type, balance_type, alloc_type>::lower_bound(const T& item) const {
+		return iterator(counts.lower_bound(item), 0);
+	}
+
+	// first element greater than a value
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type>
+	typename bst_multiset<T, compare_type, balance_type, alloc_type>::iterator
+		bst_multiset<T, compare_type, balance_type, alloc_type>::upper_bound(const T& item) const {
+		return iterator(counts.upper_bound(item), 0);
+	}
+
+	// every occurrence of an element: its entry and the one after
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type>
+	std::pair<typename bst_multiset<T, compare_type, balance_type, alloc_type>::iterator,
+		typename bst_multiset<T, compare_type, balance_type, alloc_type>::iterator>
+		bst_multiset<T, compare_type, balance_type, alloc_type>::equal_range(const T& item) const {
+
+		entry_iterator e = counts.lower_bound(item); // entry of item, or of the next element
+
+		if (e != counts.end() && !counts.key_comp()(item, e->first)) { // item is present
+			entry_iterator after = e; // entry following item's
+			return { iterator(e, 0), iterator(++after, 0) };
+		}
+
+		return { iterator(e, 0), iterator(e, 0) };
+	}
+
+	// to add copies of a value (lvalue), copied only if it is new
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type>
+	typename bst_multiset<T, compare_type, balance_type, alloc_type>::iterator
+		bst_multiset<T, compare_type, balance_type, alloc_type>::insert(const T& val, size_t copies) {
+
+		if (!copies) { // an entry with no occurrences would break the iterators
+			return end();
+		}
+
+		entry_iterator e = counts.try_emplace(val, 0).first; // one descent
+
+		e->second = e->second + copies;
+		total = total + copies;
+
+		return iterator(e, e->second - 1);
+	}
+
+	// to add a value (rvalue), moved only if it is new
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type>
+	typename bst_multiset<T, compare_type, balance_type, alloc_type>::iterator
+		bst_multiset<T, compare_type, balance_type, alloc_type>::insert(T&& val) {
+
+		entry_iterator e = counts.try_emplace(std::move(val), 0).first; // one descent
+
+		e->second = e->second + 1;
+		total = total + 1;
+
+		return iterator(e, e->second - 1);
+	}
+
+	// remove one occurrence, dropping the node with the last one
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type>
+	typename bst_multiset<T, compare_type, balance_type, alloc_type>::iterator
+		bst_multiset<T, compare_type, balance_type, alloc_type>::erase(iterator bad) {
+
+		entry_iterator e = bad.entry; // entry losing an occurrence
+		total = total - 1;
+
+		if (e->second == 1) { // the node goes; the next entry survives
+			entry_iterator after = e;
+			++after;
+			counts.erase(e);
+			return iterator(after, 0);
+		}
+
+		e->second = e->second - 1; // the last slot goes; the occurrence after bad moves into bad's
+
+		if (bad.index < e->second) {
+			return bad;
+		}
+
+		return iterator(++e, 0);
+	}
+
+	// remove every occurrence of an element
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type>
+	size_t bst_multiset<T, compare_type, balance_type, alloc_type>::erase(const T& item) {
+
+		entry_iterator e = counts.find(item); // entry of the element, if any
+
+		if (e == counts.end()) {
+			return 0;
+		}
+
+		size_t removed = e->second; // its multiplicity
+		counts.erase(e);
+		total = total - removed;
+
+		return removed;
+	}
+
+	// remove one occurrence of an element
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type>
+	size_t bst_multiset<T, compare_type, balance_type, alloc_type>::erase_one(const T& item) {
+
+		entry_iterator e = counts.find(item); // entry of the element, if any
+
+		if (e == counts.end()) {
+			return 0;
+		}
+
+		erase(iterator(e, 0));
+		return 1;
+	}
+
+	// swap two multisets
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type>
+	void bst_multiset<T, compare_type, balance_type, alloc_type>::swap(bst_multiset& other) {
+
+		counts.swap(other.counts);
+		std::swap(total, other.total);
+	}
+
+	// first occurrence of the smallest element
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type>
+	typename bst_multiset<T, compare_type, balance_type, alloc_type>::iterator
+		bst_multiset<T, compare_type, balance_type, alloc_type>::begin() const {
+		return iterator(counts.begin(), 0);
+	}
+
+	// past-the-end position
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type>
+	typename bst_multiset<T, compare_type, balance_type, alloc_type>::iterator
+		bst_multiset<T, compare_type, balance_type, alloc_type>::end() const {
+		return iterator(counts.end(), 0);
+	}
+
+	// remove every element
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type>
+	void bst_multiset<T, compare_type, balance_type, alloc_type>::clear() {
+
+		counts.clear();
+		total = 0;
+	}
+}
+
+#endif
@@ -0,0 +1,993 @@
+#ifndef BTREE_H
+#define BTREE_H
+
+#include <utility>
+#include <functional>
+#include <algorithm>
+#include <iterator>
+#include <type_traits>
+#include <cstddef>
+
+#include "bst.h"
+
+namespace binarysearch {
+
+	/**
+	* templated B+ tree class with the same interface as bst
+	* many keys per node are kept in contiguous arrays and the leaves are
+	* linked, so lookups touch a few cache lines per level instead of one
+	* node per level; unlike bst, insert and erase invalidate iterators
+	* T must be default constructible and move assignable
+	* @param T the data type of the tree
+	* @param compare_type the comparison function to compare the data
+	* @param node_bytes size of the key array in each node (at least 4 keys)
+	*/
+	template <typename T, typename compare_type = std::less<T>, size_t node_bytes = 256>
+	class btree {
+
+	public:
+
+		/**
+		* constructor which initializes: pred, root, head, tail, tree_size, and levels
+		* @param pred_input the comparison function to compare the data
+		*/
+		btree(const compare_type& pred_input = compare_type()) :
+			pred(pred_input), root(nullptr), head(nullptr), tail(nullptr), tree_size(0), levels(0) {}
+
+		/**
+		* iterator class declaration
+		*/
+		class iterator;
+
+		/**
+		* destructor which removes every element through clear
+		*/
+		~btree() { clear(); }
+
+		/**
+		* copy constructor
+		* @param rhs copy-from tree
+		*/
+		btree(const btree& rhs);
+
+		/**
+		* move constructor
+		* @param that rvalue reference to move-from tree
+		*/
+		btree(btree&& that) noexcept;
+
+		/**
+		* copy/move assignment operator
+		* @param that copy/move-from tree
+		*/
+		btree& operator=(btree that) &;
+
+		/**
+		* checks if a tree contains a particular element
+		* @param item the type T element to look for
+		* @return iterator to the element
+		*/
+		iterator find(const T& item) const;
+
+		/**
+		* checks if a tree contains an element equivalent to key, without
+		* constructing a T (only with a transparent comparator)
+		* @param key value comparable with T through compare_type
+		* @return iterator to the element
+		*/
+		template <typename K, typename C = compare_type,
+			typename = std::enable_if_t<detail::is_transparent<C>::value>>
+		iterator find(const K& key) const;
+
+		/**
+		* counts elements equivalent to a value
+		* @param item the type T element to look for
+		* @return 1 if present, 0 otherwise
+		*/
+		size_t count(const T& item) const;
+
+		/**
+		* checks if a tree contains a particular element
+		* @param item the type T element to look for
+		* @return whether an equivalent element is present
+		*/
+		bool contains(const T& item) const;
+
+		/**
+		* first element not less than a value
+		* @param item the type T bound
+		* @return iterator to that element, or end()
+		*/
+		iterator lower_bound(const T& item) const;
+
+		/**
+		* first element greater than a value
+		* @param item the type T bound
+		* @return iterator to that element, or end()
+		*/
+		iterator upper_bound(const T& item) const;
+
+		/**
+		* swaps two trees
+		* @param other tree to swap the implicit "this" tree with
+		*/
+		void swap(btree& other);
+
+		/**
+		* returns an iterator to the "smallest" element
+		* @return iterator to the first slot of the first leaf
+		*/
+		iterator begin() const;
+
+		/**
+		* returns an iterator to past-the-end position
+		* @return iterator to nullptr
+		*/
+		iterator end() const;
+
+		/**
+		* adds given lvalue to the tree
+		* @param value the element to be added
+		* @return iterator to the element with an equivalent value and
+		* whether value was inserted (false if it was already present)
+		*/
+		std::pair<iterator, bool> insert(const T& value);
+
+		/**
+		* adds given rvalue to the tree
+		* @param value the element to be added
+		* @return iterator to the element with an equivalent value and
+		* whether value was inserted (false if it was already present)
+		*/
+		std::pair<iterator, bool> insert(T&& value);
+
+		/**
+		* removes given value from the tree
+		* @param bad iterator to the element to remove
+		*/
+		void erase(iterator bad);
+
+		/**
+		* removes the element equivalent to a value, if any
+		* @param item the type T element to remove
+		* @return number of elements removed (0 or 1)
+		*/
+		size_t erase(const T& item);
+
+		/**
+		* templated variadic function to construct T and
+		* attempt to place it within the tree
+		* @param args variadic list of arguments used to construct T
+		* @return iterator to the element with an equivalent value and
+		* whether the new element was inserted
+		*/
+		template <typename... Types>
+		std::pair<iterator, bool> emplace(Types&&... args);
+
+		/**
+		* accessor to tree_size
+		* @return tree_size
+		*/
+		size_t size() const { return tree_size; }
+
+		/**
+		* number of node levels from the root to the leaves
+		* @return height of the tree (0 if empty)
+		*/
+		size_t height() const { return levels; }
+
+		/**
+		* removes every element, keeping the comparator
+		*/
+		void clear();
+
+		/**
+		* number of keys each node holds
+		*/
+		static constexpr size_t capacity = node_bytes / sizeof(T) < 4 ? 4 : node_bytes / sizeof(T);
+
+	private:
+		static constexpr size_t min_fill = capacity / 2; // fewest keys in a non-root node
+
+		struct node { // fields shared by leaves and inner nodes
+			size_t count; // keys in use
+			bool is_leaf; // whether this is a leaf
+		};
+
+		struct leaf : node { // holds the elements, linked in order
+			T keys[capacity]; // sorted elements
+			leaf* prev; // previous leaf in order
+			leaf* next; // next leaf in order
+		};
+
+		struct inner : node { // routes searches: keys[i] separates children i and i+1
+			T keys[capacity]; // separators: child i < keys[i] <= child i + 1
+			node* children[capacity + 1]; // subtrees
+		};
+
+		struct step { // one inner node on the path from the root
+			inner* n; // the node
+			size_t i; // index of the child descended into
+		};
+
+		static constexpr size_t max_levels = 64; // more than enough for any size_t count
+
+		compare_type pred; // comparison function to compare the data
+		node* root; // root node (a leaf while the tree is small)
+		leaf* head; // first leaf
+		leaf* tail; // last leaf, for --end()
+		size_t tree_size; // number of elements in the tree
+		size_t levels; // height of the tree
+
+		// first key position in a leaf not less than key
+		template <typename K>
+		size_t leafIndex(const leaf*, const K&) const;
+
+		// child to descend into: number of separators not greater than key
+		template <typename K>
+		size_t childIndex(const inner*, const K&) const;
+
+		// descend to the leaf that would hold key, recording the path
+		template <typename K>
+		leaf* descend(const K&, step*, size_t&) const;
+
+		// iterator to the element equivalent to key, or end()
+		template <typename K>
+		iterator findKey(const K&) const;
+
+		template <typename V>
+		std::pair<iterator, bool> insertValue(V&&); // shared insert path
+
+		// insert a separator and right sibling above a split node, taking
+		// any inner node it needs from the spares allocated beforehand
+		void insertIntoParent(step*, size_t, node*, T&&, node*, inner**);
+
+		void rebalanceLeaf(step*, size_t, leaf*); // fix an underfull leaf
+		void removeFromInner(step*, size_t, size_t); // drop separator k and child k + 1
+		void rebalanceInner(step*, size_t); // fix an underfull inner node
+
+		node* cloneNode(const node*, leaf*&); // deep copy, relinking leaves in order
+		void deleteNode(node*); // delete a subtree
+	};
+
+	//nested iterator class definition
+	template <typename T, typename compare_type, size_t node_bytes>
+	class btree<T, compare_type, node_bytes>::iterator { //nested iterator class
+
+		friend btree; //to allow iterator construction by btree operations
+
+		public:
+
+		// standard iterator traits (bidirectional, read-only)
+		using iterator_category = std::bidirectional_iterator_tag;
+		using value_type = T;
+		using difference_type = std::ptrdiff_t;
+		using pointer = const T*;
+		using reference = const T&;
+
+		/**
+		* overloaded prefix ++
+		*/
+		iterator& operator++() {
+
+			index = index + 1; // next slot
+
+			if (index == curr->count) { // leaf exhausted, nullptr leaf specifies end
+				curr = curr->next;
+				index = 0;
+			}
+			return *this;
+		}
+
+		/**
+		* overloaded postfix ++
+		*/
+		iterator operator++(int) {
+
+			auto copy(*this); // copy of current position
+			++(*this);
+			return copy;
+		}
+
+		/**
+		* overloaded prefix -- (--end() is the last element)
+		*/
+		iterator& operator--() {
+
+			if (!curr) { // past-the-end: move to last element
+				curr = container->tail;
+				index = curr->count - 1;
+			}
+			else if (index == 0) { // first slot: move to previous leaf
+				curr = curr->prev;
+				index = curr->count - 1;
+			}
+			else { // earlier slot in this leaf
+				index = index - 1;
+			}
+			return *this;
+		}
+
+		/**
+		* overloaded postfix --
+		*/
+		iterator operator--(int) {
+
+			auto copy(*this); // copy of current position
+			--(*this);
+			return copy;
+		}
+
+		/**
+		* overloaded == comparison operator
+		*/
+		friend bool operator==(const iterator& left, const iterator& right) {
+			return left.curr == right.curr && left.index == right.index;
+		}
+
+		/**
+		* overloaded != comparison operator
+		*/
+		friend bool operator!=(const iterator& left, const iterator& right) {
+			return !(left == right);
+		}
+
+		/**
+		* overload dereferencing operator (without modifying tree element)
+		*/
+		const T& operator*() const {
+			return curr->keys[index]; // element in current slot
+		}
+
+		/**
+		* overload the operator arrow (without modifying tree element)
+		*/
+		const T* operator->() const {
+			return &curr->keys[index]; // element in current slot
+		}
+
+	private:
+
+		/**
+		* constructor which initializes curr, index, and container
+		* @param l the current leaf
+		* @param i the slot within the leaf
+		* @param c the tree container
+		*/
+		iterator(leaf* l = nullptr, size_t i = 0, const btree* c = nullptr) :
+			curr(l), index(i), container(c) {}
+
+		leaf* curr; // current leaf
+		size_t index; // slot within the leaf
+		const btree* container; // holding container
+	};
+
+	// first key position in a leaf not less than key
+	template <typename T, typename compare_type, size_t node_bytes>
+	template <typename K>
+	size_t btree<T, compare_type, node_bytes>::leafIndex(const leaf* l, const K& key) const {
+
+		// binary search within the contiguous key array
+		auto it = std::lower_bound(l->keys, l->keys + l->count, key,
+			[this](const T& value, const K& k) { return pred(value, k); });
+
+		return static_cast<size_t>(it - l->keys);
+	}
+
+	// number of separators not greater than key
+	template <typename T, typename compare_type, size_t node_bytes>
+	template <typename K>
+	size_t btree<T, compare_type, node_bytes>::childIndex(const inner* n, const K& key) const {
+
+		// keys equal to a separator live in the right child
+		auto it = std::upper_bound(n->keys, n->keys + n->count, key,
+			[this](const K& k, const T& value) { return pred(k, value); });
+
+		return static_cast<size_t>(it - n->keys);
+	}
+
+	// descend to the leaf that would hold key
+	template <typename T, typename compare_type, size_t node_bytes>
+	template <typename K>
+	typename btree<T, compare_type, node_bytes>::leaf*
+		btree<T, compare_type, node_bytes>::descend(const K& key, step* path, size_t& depth) const {
+
+		node* n = root; // start at the root
+		depth = 0;
+
+		while (!n->is_leaf) { // one binary search per level
+
+			inner* in = static_cast<inner*>(n);
+			size_t i = childIndex(in, key);
+
+			if (path) { // caller will modify the tree
+				path[depth] = { in, i };
+			}
+
+			depth = depth + 1;
+			n = in->children[i];
+		}
+
+		return static_cast<leaf*>(n);
+	}
+
+	// iterator to the element equivalent to key
+	template <typename T, typename compare_type, size_t node_bytes>
+	template <typename K>
+	typename btree<T, compare_type, node_bytes>::iterator
+		btree<T, compare_type, node_bytes>::findKey(const K& key) const {
+
+		if (!root) { // tree is empty
+			return end();
+		}
+
+		size_t depth; // unused
+		leaf* l = descend(key, nullptr, depth);
+		size_t i = leafIndex(l, key);
+
+		// an equivalent key can only be in this leaf
+		if (i < l->count && !pred(key, l->keys[i])) {
+			return iterator(l, i, this);
+		}
+
+		return end();
+	}
+
+	// finds value in tree
+	template <typename T, typename compare_type, size_t node_bytes>
+	typename btree<T, compare_type, node_bytes>::iterator
+		btree<T, compare_type, node_bytes>::find(const T& val) const {
+		return findKey(val);
+	}
+
+	// finds key in tree without constructing T
+	template <typename T, typename compare_type, size_t node_bytes>
+	template <typename K, typename C, typename>
+	typename btree<T, compare_type, node_bytes>::iterator
+		btree<T, compare_type, node_bytes>::find(const K& key) const {
+		return findKey(key);
+	}
+
+	// counts elements equivalent to value
+	template <typename T, typename compare_type, size_t node_bytes>
+	size_t btree<T, compare_type, node_bytes>::count(const T& val) const {
+		return findKey(val) != end() ? 1 : 0;
+	}
+
+	// checks for an element equivalent to value
+	template <typename T, typename compare_type, size_t node_bytes>
+	bool btree<T, compare_type, node_bytes>::contains(const T& val) const {
+		return findKey(val) != end();
+	}
+
+	// first element not less than value
+	template <typename T, typename compare_type, size_t node_bytes>
+	typename btree<T, compare_type, node_bytes>::iterator
+		btree<T, compare_type, node_bytes>::lower_bound(const T& val) const {
+
+		if (!root) { // tree is empty
+			return end();
+		}
+
+		size_t depth; // unused
+		leaf* l = descend(val, nullptr, depth);
+		iterator it(l, leafIndex(l, val), this);
+
+		if (it.index == l->count) { // bound is the first slot of the next leaf
+			it.curr = l->next;
+			it.index = 0;
+		}
+
+		return it;
+	}
+
+	// first element greater than value
+	template <typename T, typename compare_type, size_t node_bytes>
+	typename btree<T, compare_type, node_bytes>::iterator
+		btree<T, compare_type, node_bytes>::upper_bound(const T& val) const {
+
+		iterator it = lower_bound(val); // first element not less than value
+
+		if (it != end() && !pred(val, *it)) { // skip the equivalent element
+			++it;
+		}
+
+		return it;
+	}
+
+	// swap two trees (member function)
+	template <typename T, typename compare_type, size_t node_bytes>
+	void btree<T, compare_type, node_bytes>::swap(btree& other) {
+
+		std::swap(pred, other.pred);
+		std::swap(root, other.root);
+		std::swap(head, other.head);
+		std::swap(tail, other.tail);
+		std::swap(tree_size, other.tree_size);
+		std::swap(levels, other.levels);
+	}
+
+	// swap two trees (free function)
+	template <typename T, typename compare_type, size_t node_bytes>
+	void swap(btree<T, compare_type, node_bytes>& first, btree<T, compare_type, node_bytes>& second) {
+
+		first.swap(second); // use member function to swap first tree with second
+	}
+
+	// iterator to the smallest element
+	template <typename T, typename compare_type, size_t node_bytes>
+	typename btree<T, compare_type, node_bytes>::iterator btree<T, compare_type, node_bytes>::begin() const {
+		return iterator(head, 0, this); // null head is end()
+	}
+
+	// iterator to past-the-end position
+	template <typename T, typename compare_type, size_t node_bytes>
+	typename btree<T, compare_type, node_bytes>::iterator btree<T, compare_type, node_bytes>::end() const {
+		return iterator(nullptr, 0, this);
+	}
+
+	// to add a value to the tree (lvalue)
+	template <typename T, typename compare_type, size_t node_bytes>
+	std::pair<typename btree<T, compare_type, node_bytes>::iterator, bool>
+		btree<T, compare_type, node_bytes>::insert(const T& val) {
+		return insertValue(val);
+	}
+
+	// to add a value to the tree (rvalue)
+	template <typename T, typename compare_type, size_t node_bytes>
+	std::pair<typename btree<T, compare_type, node_bytes>::iterator, bool>
+		btree<T, compare_type, node_bytes>::insert(T&& val) {
+		return insertValue(std::move(val));
+	}
+
+	// construct a T and attempt to place it within the tree
+	template <typename T, typename compare_type, size_t node_bytes>
+	template <typename... Types>
+	std::pair<typename btree<T, compare_type, node_bytes>::iterator, bool>
+		btree<T, compare_type, node_bytes>::emplace(Types&&... args) {
+		return insertValue(T(std::forward<Types>(args)...));
+	}
+
+	// shared insert path: descend, then split full nodes on the way back up
+	template <typename T, typename compare_type, size_t node_bytes>
+	template <typename V>
+	std::pair<typename btree<T, compare_type, node_bytes>::iterator, bool>
+		btree<T, compare_type, node_bytes>::insertValue(V&& val) {
+
+		if (!root) { // tree is empty: a single leaf is the root
+
+			leaf* l = new leaf();
+			l->count = 0;
+			l->is_leaf = true;
+			l->prev = nullptr;
+			l->next = nullptr;
+
+			root = l;
+			head = l;
+			tail = l;
+			levels = 1;
+		}
+
+		step path[max_levels]; // inner nodes above the leaf
+		size_t depth; // number of entries in path
+		leaf* l = descend(val, path, depth);
+		size_t i = leafIndex(l, val); // insertion slot
+
+		if (i < l->count && !pred(val, l->keys[i])) { // already present
+			return { iterator(l, i, this), false };
+		}
+
+		if (l->count == capacity) { // leaf is full: split it in half first
+
+			size_t mid = capacity / 2; // keys kept on the left
+
+			// full ancestors split too, and a full root needs a new one above it
+			size_t needed = 0; // inner nodes the split will allocate
+			while (needed < depth && path[depth - 1 - needed].n->count == capacity) {
+				needed = needed + 1;
+			}
+			if (needed == depth) {
+				needed = needed + 1;
+			}
+
+			// allocate and copy everything up front so a throw leaves the tree as it was
+			leaf* r = new leaf();
+			inner* spare[max_levels + 1]; // inner nodes for insertIntoParent
+			size_t allocated = 0; // spares allocated so far
+			T separator; // first key of the right half, copied into the parent
+
+			try {
+				for (; allocated < needed; allocated = allocated + 1) {
+					spare[allocated] = new inner();
+				}
+				separator = l->keys[mid];
+			}
+			catch (...) {
+				for (size_t k = 0; k < allocated; k = k + 1) {
+					delete spare[k];
+				}
+				delete r;
+				throw;
+			}
+
+			r->is_leaf = true;
+
+			std::move(l->keys + mid, l->keys + capacity, r->keys); // upper half moves right
+			r->count = capacity - mid;
+			l->count = mid;
+
+			// link the new leaf after l
+			r->prev = l;
+			r->next = l->next;
+
+			if (l->next) {
+				l->next->prev = r;
+			}
+			else {
+				tail = r;
+			}
+
+			l->next = r;
+
+			// link r above before placing the new element: the separator stays
+			// r's smallest key whichever half the element goes into
+			insertIntoParent(path, depth, l, std::move(separator), r, spare);
+
+			if (i > mid) { // new element belongs in the right half
+				i = i - mid;
+				l = r;
+			}
+		}
+
+		// room in the leaf now: fill the free slot first, so a throwing copy
+		// leaves the keys untouched, then rotate it down past the larger keys
+		l->keys[l->count] = std::forward<V>(val);
+		std::rotate(l->keys + i, l->keys + l->count, l->keys + l->count + 1);
+		l->count = l->count + 1;
+		tree_size = tree_size + 1;
+
+		return { iterator(l, i, this), true };
+	}
+
+	// insert separator and right sibling into the parent of a split node
+	template <typename T, typename compare_type, size_t node_bytes>
+	void btree<T, compare_type, node_bytes>::insertIntoParent(step* path, size_t depth,
+		node* left, T&& separator, node* right, inner** spare) {
+
+		if (depth == 0) { // split node was the root: grow a new root
+
+			inner* r = *spare;
+			r->is_leaf = false;
+			r->count = 1;
+			r->keys[0] = std::move(separator);
+			r->children[0] = left;
+			r->children[1] = right;
+
+			root = r;
+			levels = levels + 1;
+			return;
+		}
+
+		inner* p = path[depth - 1].n; // parent of the split node
+		size_t i = path[depth - 1].i; // left is p->children[i]
+
+		if (p->count < capacity) { // room for one more separator
+
+			std::move_backward(p->keys + i, p->keys + p->count, p->keys + p->count + 1);
+			std::move_backward(p->children + i + 1, p->children + p->count + 1, p->children + p->count + 2);
+			p->keys[i] = std::move(separator);
+			p->children[i + 1] = right;
+			p->count = p->count + 1;
+			return;
+		}
+
+		// parent is full: merge in the new entry, then split around the middle key
+		T keys[capacity + 1]; // separators including the new one
+		node* children[capacity + 2]; // children including the new one
+
+		std::move(p->keys, p->keys + i, keys);
+		keys[i] = std::move(separator);
+		std::move(p->keys + i, p->keys + capacity, keys + i + 1);
+
+		std::copy(p->children, p->children + i + 1, children);
+		children[i + 1] = right;
+		std::copy(p->children + i + 1, p->children + capacity + 1, children + i + 2);
+
+		size_t mid = (capacity + 1) / 2; // separator that moves up
+		inner* q = *spare; // new right sibling
+		q->is_leaf = false;
+
+		p->count = mid;
+		std::move(keys, keys + mid, p->keys);
+		std::copy(children, children + mid + 1, p->children);
+
+		q->count = capacity - mid;
+		std::move(keys + mid + 1, keys + capacity + 1, q->keys);
+		std::copy(children + mid + 1, children + capacity + 2, q->children);
+
+		insertIntoParent(path, depth - 1, p, std::move(keys[mid]), q, spare + 1);
+	}
+
+	// removes given value from the tree
+	template <typename T, typename compare_type, size_t node_bytes>
+	void btree<T, compare_type, node_bytes>::erase(iterator i) {
+
+		// locate the slot again by key; the key is not read after it is overwritten
+		erase(i.curr->keys[i.index]);
+	}
+
+	// removes the element equivalent to value
+	template <typename T, typename compare_type, size_t node_bytes>
+	size_t btree<T, compare_type, node_bytes>::erase(const T& val) {
+
+		if (!root) { // tree is empty
+			return 0;
+		}
+
+		step path[max_levels]; // inner nodes above the leaf
+		size_t depth; // number of entries in path
+		leaf* l = descend(val, path, depth);
+		size_t i = leafIndex(l, val); // slot of the element
+
+		if (i == l->count || pred(val, l->keys[i])) { // not present
+			return 0;
+		}
+
+		// close the gap
+		std::move(l->keys + i + 1, l->keys + l->count, l->keys + i);
+		l->count = l->count - 1;
+		tree_size = tree_size - 1;
+
+		if (depth == 0) { // leaf is the root: may shrink to nothing
+
+			if (l->count == 0) {
+
+				delete l;
+				root = nullptr;
+				head = nullptr;
+				tail = nullptr;
+				levels = 0;
+			}
+		}
+		else if (l->count < min_fill) { // borrow from or merge with a sibling
+			rebalanceLeaf(path, depth, l);
+		}
+
+		return 1;
+	}
+
+	// fix a leaf holding fewer than min_fill keys
+	template <typename T, typename compare_type, size_t node_bytes>
+	void btree<T, compare_type, node_bytes>::rebalanceLeaf(step* path, size_t depth, leaf* l) {
+
+		inner* p = path[depth - 1].n; // parent
+		size_t i = path[depth - 1].i; // l is p->children[i]
+
+		leaf* left = i > 0 ? static_cast<leaf*>(p->children[i - 1]) : nullptr;
+		leaf* right = i < p->count ? static_cast<leaf*>(p->children[i + 1]) : nullptr;
+
+		if (left && left->count > min_fill) { // borrow the largest key of the left sibling
+
+			std::move_backward(l->keys, l->keys + l->count, l->keys + l->count + 1);
+			l->keys[0] = std::move(left->keys[left->count - 1]);
+			l->count = l->count + 1;
+			left->count = left->count - 1;
+			p->keys[i - 1] = l->keys[0];
+		}
+		else if (right && right->count > min_fill) { // borrow the smallest key of the right sibling
+
+			l->keys[l->count] = std::move(right->keys[0]);
+			l->count = l->count + 1;
+			std::move(right->keys + 1, right->keys + right->count, right->keys);
+			right->count = right->count - 1;
+			p->keys[i] = right->keys[0];
+		}
+		else {
+
+			if (left) { // merge l into its left sibling
+				right = l;
+				l = left;
+				i = i - 1;
+			}
+
+			// append right's keys to l and unlink right
+			std::move(right->keys, right->keys + right->count, l->keys + l->count);
+			l->count = l->count + right->count;
+			l->next = right->next;
+
+			if (right->next) {
+				right->next->prev = l;
+			}
+			else {
+				tail = l;
+			}
+
+			delete right;
+			removeFromInner(path, depth - 1, i);
+		}
+	}
+
+	// drop separator k and child k + 1 from the inner node at path[depth]
+	template <typename T, typename compare_type, size_t node_bytes>
+	void btree<T, compare_type, node_bytes>::removeFromInner(step* path, size_t depth, size_t k) {
+
+		inner* p = path[depth].n;
+
+		std::move(p->keys + k + 1, p->keys + p->count, p->keys + k);
+		std::copy(p->children + k + 2, p->children + p->count + 1, p->children + k + 1);
+		p->count = p->count - 1;
+
+		if (depth == 0) { // p is the root
+
+			if (p->count == 0) { // root has a single child: the tree gets shorter
+
+				root = p->children[0];
+				delete p;
+				levels = levels - 1;
+			}
+		}
+		else if (p->count < min_fill) { // borrow from or merge with a sibling
+			rebalanceInner(path, depth);
+		}
+	}
+
+	// fix the inner node at path[depth] holding fewer than min_fill keys
+	template <typename T, typename compare_type, size_t node_bytes>
+	void btree<T, compare_type, node_bytes>::rebalanceInner(step* path, size_t depth) {
+
+		inner* n = path[depth].n; // underfull node
+		inner* p = path[depth - 1].n; // parent
+		size_t i = path[depth - 1].i; // n is p->children[i]
+
+		inner* left = i > 0 ? static_cast<inner*>(p->children[i - 1]) : nullptr;
+		inner* right = i < p->count ? static_cast<inner*>(p->children[i + 1]) : nullptr;
+
+		if (left && left->count > min_fill) { // rotate through the parent from the left
+
+			std::move_backward(n->keys, n->keys + n->count, n->keys + n->count + 1);
+			std::copy_backward(n->children, n->children + n->count + 1, n->children + n->count + 2);
+			n->keys[0] = std::move(p->keys[i - 1]);
+			n->children[0] = left->children[left->count];
+			n->count = n->count + 1;
+
+			p->keys[i - 1] = std::move(left->keys[left->count - 1]);
+			left->count = left->count - 1;
+		}
+		else if (right && right->count > min_fill) { // rotate through the parent from the right
+
+			n->keys[n->count] = std::move(p->keys[i]);
+			n->children[n->count + 1] = right->children[0];
+			n->count = n->count + 1;
+
+			p->keys[i] = std::move(right->keys[0]);
+			std::move(right->keys + 1, right->keys + right->count, right->keys);
+			std::copy(right->children + 1, right->children + right->count + 1, right->children);
+			right->count = right->count - 1;
+		}
+		else {
+
+			if (left) { // merge n into its left sibling
+				right = n;
+				n = left;
+				i = i - 1;
+			}
+
+			// pull the separator down and append right's entries
+			n->keys[n->count] = std::move(p->keys[i]);
+			std::move(right->keys, right->keys + right->count, n->keys + n->count + 1);
+			std::copy(right->children, right->children + right->count + 1, n->children + n->count + 1);
+			n->count = n->count + 1 + right->count;
+
+			delete right;
+			removeFromInner(path, depth - 1, i);
+		}
+	}
+
+	// delete a subtree (depth is logarithmic, so recursion is bounded)
+	template <typename T, typename compare_type, size_t node_bytes>
+	void btree<T, compare_type, node_bytes>::deleteNode(node* n) {
+
+		if (n->is_leaf) {
+			delete static_cast<leaf*>(n);
+			return;
+		}
+
+		inner* in = static_cast<inner*>(n);
+
+		for (size_t i = 0; i <= in->count; ++i) {
+			deleteNode(in->children[i]);
+		}
+
+		delete in;
+	}
+
+	// removes every element from the tree
+	template <typename T, typename compare_type, size_t node_bytes>
+	void btree<T, compare_type, node_bytes>::clear() {
+
+		if (root) {
+			deleteNode(root);
+		}
+
+		root = nullptr;
+		head = nullptr;
+		tail = nullptr;
+		tree_size = 0;
+		levels = 0;
+	}
+
+	// deep copy of a subtree, linking copied leaves after prev
+	template <typename T, typename compare_type, size_t node_bytes>
+	typename btree<T, compare_type, node_bytes>::node*
+		btree<T, compare_type, node_bytes>::cloneNode(const node* n, leaf*& prev) {
+
+		if (n->is_leaf) {
+
+			const leaf* src = static_cast<const leaf*>(n);
+			leaf* l = new leaf(*src); // copies count and keys
+
+			l->prev = prev;
+			l->next = nullptr;
+
+			if (prev) { // link after the previous copied leaf
+				prev->next = l;
+			}
+			else {
+				head = l;
+			}
+
+			prev = l;
+			return l;
+		}
+
+		const inner* src = static_cast<const inner*>(n);
+		inner* in = new inner(*src); // copies count and separators
+		size_t copied = 0; // children cloned so far
+
+		try {
+			for (; copied <= src->count; ++copied) {
+				in->children[copied] = cloneNode(src->children[copied], prev);
+			}
+		}
+		catch (...) { // T's copy threw, free this node's copies
+			for (size_t i = 0; i < copied; ++i) {
+				deleteNode(in->children[i]);
+			}
+			delete in;
+			throw;
+		}
+
+		return in;
+	}
+
+	// copy constructor
+	template <typename T, typename compare_type, size_t node_bytes>
+	btree<T, compare_type, node_bytes>::btree(const btree& rhs) : btree(rhs.pred) {
+
+		if (rhs.root) { // clone node for node, no comparisons
+
+			leaf* last = nullptr; // last copied leaf
+			root = cloneNode(rhs.root, last);
+			tail = last;
+			tree_size = rhs.tree_size;
+			levels = rhs.levels;
+		}
+	}
+
+	// move constructor
+	template <typename T, typename compare_type, size_t node_bytes>
+	btree<T, compare_type, node_bytes>::btree(btree&& that) noexcept : btree(that.pred) {
+
+		(*this).swap(that); // swap implicit tree with given tree
+	}
+
+	// copy/move assignment operator
+	template <typename T, typename compare_type, size_t node_bytes>
+	btree<T, compare_type, node_bytes>& btree<T, compare_type, node_bytes>::operator=(btree that) & {
+
+		(*this).swap(that); // swap implicit tree with given tree
+		return *this; // return implicit tree
+	}
+}
+
+#endif
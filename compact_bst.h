@@ -0,0 +1,1077 @@
+#ifndef COMPACT_BST_H
+#define COMPACT_BST_H
+
+#include <utility>
+#include <functional>
+#include <algorithm>
+#include <iterator>
+#include <type_traits>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <vector>
+
+#include "bst.h"
+
+namespace binarysearch {
+
+	/**
+	* templated sorted set with the bst interface and a compact node layout
+	* nodes live in fixed-size chunks and link to their children by 31-bit
+	* index, with the color in the spare bit and no parent link, so a node is
+	* T plus 8 bytes (12 bytes for int against 32 in bst); balancing is a
+	* left-leaning red-black tree, and iterators keep the path from the root
+	* instead of following parents; insert and erase invalidate iterators, and
+	* compare_type must not throw during erase, which rebalances on the way down
+	* @param T the data type of the tree
+	* @param compare_type the comparison function to compare the data
+	* @param alloc_type the allocator, rebound internally to the node type
+	*/
+	template <typename T, typename compare_type = std::less<T>, typename alloc_type = std::allocator<T>>
+	class compact_bst {
+
+		struct node; // element, child indices and color
+
+	public:
+
+		/**
+		* constructor which initializes: pred, root, tree_size, free_head, used, and alloc
+		* @param pred_input the comparison function to compare the data
+		* @param alloc_input the allocator used for the node chunks
+		*/
+		compact_bst(const compare_type& pred_input = compare_type(),
+			const alloc_type& alloc_input = alloc_type()) :
+			pred(pred_input), root(nil), tree_size(0), free_head(nil), used(0), alloc(alloc_input) {}
+
+		/**
+		* constructor which initializes: pred, root, tree_size, free_head, used, and alloc
+		* @param alloc_input the allocator used for the node chunks
+		*/
+		explicit compact_bst(const alloc_type& alloc_input) :
+			compact_bst(compare_type(), alloc_input) {}
+
+		/**
+		* range constructor (of equivalent elements the first one is kept)
+		* @param first beginning of the range
+		* @param last end of the range
+		* @param pred_input the comparison function to compare the data
+		* @param alloc_input the allocator used for the node chunks
+		*/
+		template <typename InputIt, typename = typename std::iterator_traits<InputIt>::iterator_category>
+		compact_bst(InputIt first, InputIt last, const compare_type& pred_input = compare_type(),
+			const alloc_type& alloc_input = alloc_type()) :
+			compact_bst(pred_input, alloc_input) {
+
+			for (; first != last; ++first) {
+				insert(*first);
+			}
+		}
+
+		/**
+		* iterator class declaration
+		*/
+		class iterator;
+
+		/**
+		* destructor which removes every element through clear
+		*/
+		~compact_bst() { clear(); }
+
+		/**
+		* copy constructor which clones the shape into fresh, dense chunks
+		* @param rhs copy-from tree
+		*/
+		compact_bst(const compact_bst& rhs);
+
+		/**
+		* move constructor
+		* @param that rvalue reference to move-from tree
+		*/
+		compact_bst(compact_bst&& that) noexcept;
+
+		/**
+		* copy/move assignment operator
+		* @param that copy/move-from tree
+		*/
+		compact_bst& operator=(compact_bst that) &;
+
+		/**
+		* checks if a tree contains a particular element
+		* @param item the type T element to look for
+		* @return iterator to the element
+		*/
+		iterator find(const T& item) const;
+
+		/**
+		* checks if a tree contains an element equivalent to key, without
+		* constructing a T (only with a transparent comparator)
+		* @param key value comparable with T through compare_type
+		* @return iterator to the element
+		*/
+		template <typename K, typename C = compare_type,
+			typename = std::enable_if_t<detail::is_transparent<C>::value>>
+		iterator find(const K& key) const;
+
+		/**
+		* counts elements equivalent to a value
+		* @param item the type T element to look for
+		* @return 1 if present, 0 otherwise
+		*/
+		size_t count(const T& item) const { return findIndex(item) != nil ? 1 : 0; }
+
+		/**
+		* checks if a tree contains a particular element
+		* @param item the type T element to look for
+		* @return whether an equivalent element is present
+		*/
+		bool contains(const T& item) const { return findIndex(item) != nil; }
+
+		/**
+		* first element not less than a value
+		* @param item the type T bound
+		* @return iterator to that element, or end()
+		*/
+		iterator lower_bound(const T& item) const;
+
+		/**
+		* first element greater than a value
+		* @param item the type T bound
+		* @return iterator to that element, or end()
+		*/
+		iterator upper_bound(const T& item) const;
+
+		/**
+		* swaps two trees
+		* @param other tree to swap the implicit "this" tree with
+		*/
+		void swap(compact_bst& other);
+
+		/**
+		* returns an iterator to the "smallest" element
+		* @return iterator to the leftmost node
+		*/
+		iterator begin() const;
+
+		/**
+		* returns an iterator to past-the-end position
+		* @return iterator with an empty path
+		*/
+		iterator end() const;
+
+		/**
+		* adds given lvalue to the tree
+		* @param value the element to be added
+		* @return iterator to the element with an equivalent value and
+		* whether value was inserted (false if it was already present)
+		*/
+		std::pair<iterator, bool> insert(const T& value);
+
+		/**
+		* adds given rvalue to the tree
+		* @param value the element to be added
+		* @return iterator to the element with an equivalent value and
+		* whether value was inserted (false if it was already present)
+		*/
+		std::pair<iterator, bool> insert(T&& value);
+
+		/**
+		* templated variadic function to construct T and
+		* attempt to place it within the tree
+		* @param args variadic list of arguments used to construct T
+		* @return iterator to the element with an equivalent value and
+		* whether the new element was inserted
+		*/
+		template <typename... Types>
+		std::pair<iterator, bool> emplace(Types&&... args);
+
+		/**
+		* removes given value from the tree
+		* @param bad iterator to the element to remove
+		*/
+		void erase(iterator bad);
+
+		/**
+		* removes the element equivalent to a value, if any
+		* @param item the type T element to remove
+		* @return number of elements removed (0 or 1)
+		*/
+		size_t erase(const T& item);
+
+		/**
+		* accessor to tree_size
+		* @return tree_size
+		*/
+		size_t size() const { return tree_size; }
+
+		/**
+		* number of nodes on the longest root-to-leaf path
+		* @return height of the tree (0 if empty)
+		*/
+		size_t height() const;
+
+		/**
+		* removes every element and returns every chunk, keeping the
+		* comparator and allocator
+		*/
+		void clear();
+
+		/**
+		* bytes of node storage held, including freed and not yet used slots
+		* @return chunks held times the bytes in a chunk
+		*/
+		size_t memory_bytes() const { return chunks.size() * chunk_size * sizeof(node); }
+
+		/**
+		* accessor to a copy of the allocator
+		* @return the allocator, rebound to T
+		*/
+		alloc_type get_allocator() const { return alloc_type(alloc); }
+
+	private:
+		static constexpr uint32_t nil = 0x7fffffff; // null link, also the bound on indices
+		static constexpr size_t chunk_bits = 10; // log2 of nodes per chunk
+		static constexpr size_t chunk_size = size_t(1) << chunk_bits; // nodes per chunk
+		static constexpr size_t max_depth = 64; // bound on the height (2 log2(2^31))
+
+		struct free_slot { uint32_t next; }; // link stored in a freed slot
+
+		// allocator rebound to nodes, and its traits
+		using node_alloc_type = typename std::allocator_traits<alloc_type>::template rebind_alloc<node>;
+		using node_traits = std::allocator_traits<node_alloc_type>;
+
+		compare_type pred; // comparison function to compare the data
+		uint32_t root; // index of the root node
+		size_t tree_size; // number of elements in the tree
+		uint32_t free_head; // most recently freed slot, or nil
+		uint32_t used; // slots handed out so far, freed ones included
+		std::vector<node*> chunks; // node storage, never moved once allocated
+		node_alloc_type alloc; // allocator for the chunks
+
+		node& slot(uint32_t i) const { return chunks[i >> chunk_bits][i & (chunk_size - 1)]; }
+		bool isRed(uint32_t i) const { return i != nil && slot(i).red; } // nil counts as black
+
+		template <typename... Types>
+		uint32_t createNode(Types&&...); // construct a node in a free slot
+		void destroyNode(uint32_t); // destroy a node and free its slot
+		void destroyTree(uint32_t); // destroy every node of a subtree
+		uint32_t cloneTree(const compact_bst&, uint32_t); // copy a subtree of another tree
+
+		// node equivalent to key, or nil
+		template <typename K>
+		uint32_t findIndex(const K&) const;
+
+		// iterator to the node equivalent to key, or end()
+		template <typename K>
+		iterator findKey(const K&) const;
+
+		// link a node built from args unless an element equivalent to key is present
+		template <typename... Types>
+		std::pair<iterator, bool> insertValue(const T&, uint32_t, Types&&...);
+
+		// subtree h with a node for key linked in (n, built from args at the
+		// leaf unless given), or found set to the equivalent node; trail holds
+		// the path from that node up to the subtree's root, bottom-up
+		template <typename... Types>
+		uint32_t insertNode(uint32_t, const T&, uint32_t&, uint32_t&, iterator&, Types&&...);
+
+		// unlink and destroy the node equivalent to key, which must be present
+		template <typename K>
+		void eraseValue(const K&);
+
+		// subtree h without key (which it holds); the unlinked node goes to removed
+		template <typename K>
+		uint32_t eraseNode(uint32_t, const K&, uint32_t&);
+
+		uint32_t eraseMin(uint32_t, uint32_t&); // subtree h without its leftmost node
+
+		uint32_t rotateLeft(uint32_t); // lift the red right child of h
+		uint32_t rotateRight(uint32_t); // lift the red left child of h
+		void flipColors(uint32_t); // flip h and both children
+		uint32_t moveRedLeft(uint32_t); // make h's left child or one of its children red
+		uint32_t moveRedRight(uint32_t); // make h's right child or one of its children red
+		uint32_t balance(uint32_t, iterator* = nullptr); // restore the left-leaning shape at h, keeping a trail through it
+		void liftTrail(uint32_t, iterator&) const; // reroute a bottom-up trail after its top was rotated below x
+	};
+
+	//nested node definition
+	template <typename T, typename compare_type, typename alloc_type>
+	struct compact_bst<T, compare_type, alloc_type>::node {
+
+		/**
+		* constructor which initializes value, left, right, and red
+		* @param args arguments forwarded to T's constructor
+		*/
+		template <typename... Types>
+		explicit node(Types&&... args) :
+			value(std::forward<Types>(args)...), left(nil), right(nil), red(1) {}
+
+		T value; // element held in the node
+		uint32_t left; // index of the left child, or nil
+		uint32_t right : 31; // index of the right child, or nil
+		uint32_t red : 1; // color of the link from the parent
+	};
+
+	//nested iterator class definition
+	template <typename T, typename compare_type, typename alloc_type>
+	class compact_bst<T, compare_type, alloc_type>::iterator { //nested iterator class
+
+		friend compact_bst; //to allow iterator construction by compact_bst operations
+
+		public:
+
+		// standard iterator traits (bidirectional, read-only)
+		using iterator_category = std::bidirectional_iterator_tag;
+		using value_type = T;
+		using difference_type = std::ptrdiff_t;
+		using pointer = const T*;
+		using reference = const T&;
+
+		/**
+		* overloaded prefix ++
+		*/
+		iterator& operator++() {
+
+			uint32_t n = container->slot(path[depth - 1]).right; // successor is in the right subtree, if any
+
+			if (n != nil) {
+				for (; n != nil; n = container->slot(n).left) { // its leftmost node
+					path[depth++] = n;
+				}
+			}
+			else { // or the nearest ancestor reached through a left link
+				uint32_t child = path[--depth];
+
+				while (depth && container->slot(path[depth - 1]).right == child) {
+					child = path[--depth];
+				}
+			}
+
+			return *this;
+		}
+
+		/**
+		* overloaded postfix ++
+		*/
+		iterator operator++(int) {
+
+			auto copy(*this); // copy of current position
+			++(*this);
+			return copy;
+		}
+
+		/**
+		* overloaded prefix -- (--end() is the largest element)
+		*/
+		iterator& operator--() {
+
+			uint32_t n = depth ? container->slot(path[depth - 1]).left : container->root; // predecessor's subtree
+
+			if (n != nil) {
+				for (; n != nil; n = container->slot(n).right) { // its rightmost node
+					path[depth++] = n;
+				}
+			}
+			else { // or the nearest ancestor reached through a right link
+				uint32_t child = path[--depth];
+
+				while (depth && container->slot(path[depth - 1]).left == child) {
+					child = path[--depth];
+				}
+			}
+
+			return *this;
+		}
+
+		/**
+		* overloaded postfix --
+		*/
+		iterator operator--(int) {
+
+			auto copy(*this); // copy of current position
+			--(*this);
+			return copy;
+		}
+
+		/**
+		* overloaded == comparison operator
+		*/
+		friend bool operator==(const iterator& left, const iterator& right) {
+			return left.current() == right.current();
+		}
+
+		/**
+		* overloaded != comparison operator
+		*/
+		friend bool operator!=(const iterator& left, const iterator& right) {
+			return left.current() != right.current();
+		}
+
+		/**
+		* overload dereferencing operator
+		*/
+		const T& operator*() const {
+			return container->slot(path[depth - 1]).value;
+		}
+
+		/**
+		* overload the operator arrow
+		*/
+		const T* operator->() const {
+			return &container->slot(path[depth - 1]).value;
+		}
+
+	private:
+
+		/**
+		* constructor which initializes an empty path (end)
+		* @param c the tree container
+		*/
+		explicit iterator(const compact_bst* c) : container(c), depth(0) {}
+
+		uint32_t current() const { return depth ? path[depth - 1] : nil; } // nil at end
+
+		const compact_bst* container; // holding container
+		uint32_t path[max_depth]; // indices from the root down to the current node
+		size_t depth; // nodes on the path (0 at end)
+	};
+
+	// copy constructor: same shape, nodes renumbered densely
+	template <typename T, typename compare_type, typename alloc_type>
+	compact_bst<T, compare_type, alloc_type>::compact_bst(const compact_bst& rhs) :
+		compact_bst(rhs.pred, node_traits::select_on_container_copy_construction(rhs.alloc)) {
+
+		try {
+			root = cloneTree(rhs, rhs.root);
+		}
+		catch (...) { // free the chunks handed out so far
+			clear();
+			throw;
+		}
+
+		tree_size = rhs.tree_size;
+	}
+
+	// move constructor
+	template <typename T, typename compare_type, typename alloc_type>
+	compact_bst<T, compare_type, alloc_type>::compact_bst(compact_bst&& that) noexcept :
+		pred(that.pred), root(that.root), tree_size(that.tree_size), free_head(that.free_head),
+		used(that.used), chunks(std::move(that.chunks)), alloc(std::move(that.alloc)) {
+
+		that.root = nil;
+		that.tree_size = 0;
+		that.free_head = nil;
+		that.used = 0;
+		that.chunks.clear();
+	}
+
+	// copy/move assignment operator
+	template <typename T, typename compare_type, typename alloc_type>
+	compact_bst<T, compare_type, alloc_type>& compact_bst<T, compare_type, alloc_type>::operator=(compact_bst that) & {
+
+		swap(that);
+		return *this;
+	}
+
+	// find by value
+	template <typename T, typename compare_type, typename alloc_type>
+	typename compact_bst<T, compare_type, alloc_type>::iterator
+		compact_bst<T, compare_type, alloc_type>::find(const T& item) const {
+		return findKey(item);
+	}
+
+	// find by key
+	template <typename T, typename compare_type, typename alloc_type>
+	template <typename K, typename C, typename>
+	typename compact_bst<T, compare_type, alloc_type>::iterator
+		compact_bst<T, compare_type, alloc_type>::find(const K& key) const {
+		return findKey(key);
+	}
+
+	// first element not less than item
+	template <typename T, typename compare_type, typename alloc_type>
+	typename compact_bst<T, compare_type, alloc_type>::iterator
+		compact_bst<T, compare_type, alloc_type>::lower_bound(const T& item) const {
+
+		iterator it(this); // path of the descent
+		size_t bound = 0; // path length up to the last node not less than item
+
+		for (uint32_t n = root; n != nil; ) {
+
+			it.path[it.depth++] = n;
+
+			if (!pred(slot(n).value, item)) { // value not less than item
+				bound = it.depth;
+				n = slot(n).left;
+			}
+			else { // value less than item
+				n = slot(n).right;
+			}
+		}
+
+		it.depth = bound;
+		return it;
+	}
+
+	// first element greater than item
+	template <typename T, typename compare_type, typename alloc_type>
+	typename compact_bst<T, compare_type, alloc_type>::iterator
+		compact_bst<T, compare_type, alloc_type>::upper_bound(const T& item) const {
+
+		iterator it(this); // path of the descent
+		size_t bound = 0; // path length up to the last node greater than item
+
+		for (uint32_t n = root; n != nil; ) {
+
+			it.path[it.depth++] = n;
+
+			if (pred(item, slot(n).value)) { // value greater than item
+				bound = it.depth;
+				n = slot(n).left;
+			}
+			else { // value not greater than item
+				n = slot(n).right;
+			}
+		}
+
+		it.depth = bound;
+		return it;
+	}
+
+	// swap every member
+	template <typename T, typename compare_type, typename alloc_type>
+	void compact_bst<T, compare_type, alloc_type>::swap(compact_bst& other) {
+
+		using std::swap;
+		swap(pred, other.pred);
+		swap(root, other.root);
+		swap(tree_size, other.tree_size);
+		swap(free_head, other.free_head);
+		swap(used, other.used);
+		swap(chunks, other.chunks);
+
+		// allocators are exchanged only if they propagate on swap
+		if constexpr (node_traits::propagate_on_container_swap::value) {
+			swap(alloc, other.alloc);
+		}
+	}
+
+	// leftmost node, with its ancestors on the path
+	template <typename T, typename compare_type, typename alloc_type>
+	typename compact_bst<T, compare_type, alloc_type>::iterator
+		compact_bst<T, compare_type, alloc_type>::begin() const {
+
+		iterator it(this); // left spine of the tree
+
+		for (uint32_t n = root; n != nil; n = slot(n).left) {
+			it.path[it.depth++] = n;
+		}
+
+		return it;
+	}
+
+	// end is an empty path
+	template <typename T, typename compare_type, typename alloc_type>
+	typename compact_bst<T, compare_type, alloc_type>::iterator
+		compact_bst<T, compare_type, alloc_type>::end() const {
+		return iterator(this);
+	}
+
+	// to add a value to the tree (lvalue), copied only if absent
+	template <typename T, typename compare_type, typename alloc_type>
+	std::pair<typename compact_bst<T, compare_type, alloc_type>::iterator, bool>
+		compact_bst<T, compare_type, alloc_type>::insert(const T& val) {
+		return insertValue(val, nil, val);
+	}
+
+	// to add a value to the tree (rvalue), moved only if absent
+	template <typename T, typename compare_type, typename alloc_type>
+	std::pair<typename compact_bst<T, compare_type, alloc_type>::iterator, bool>
+		compact_bst<T, compare_type, alloc_type>::insert(T&& val) {
+		return insertValue(val, nil, std::move(val));
+	}
+
+	// construct T in a slot and attempt to place it within the tree
+	template <typename T, typename compare_type, typename alloc_type>
+	template <typename... Types>
+	std::pair<typename compact_bst<T, compare_type, alloc_type>::iterator, bool>
+		compact_bst<T, compare_type, alloc_type>::emplace(Types&&... args) {
+		uint32_t n = createNode(std::forward<Types>(args)...); // the key only exists once built
+
+		try {
+			return insertValue(slot(n).value, n);
+		}
+		catch (...) { // comparator threw before n was linked
+			destroyNode(n);
+			throw;
+		}
+	}
+
+	// erase the element an iterator points to, which is known to be present
+	template <typename T, typename compare_type, typename alloc_type>
+	void compact_bst<T, compare_type, alloc_type>::erase(iterator bad) {
+		eraseValue(*bad);
+	}
+
+	// erase an element if present
+	template <typename T, typename compare_type, typename alloc_type>
+	size_t compact_bst<T, compare_type, alloc_type>::erase(const T& item) {
+
+		if (findIndex(item) == nil) { // eraseNode expects the element to be present
+			return 0;
+		}
+
+		eraseValue(item);
+		return 1;
+	}
+
+	// top-down left-leaning red-black erase
+	template <typename T, typename compare_type, typename alloc_type>
+	template <typename K>
+	void compact_bst<T, compare_type, alloc_type>::eraseValue(const K& key) {
+
+		if (!isRed(slot(root).left) && !isRed(slot(root).right)) { // let the root lend a red link
+			slot(root).red = 1;
+		}
+
+		uint32_t removed = nil; // node unlinked by eraseNode, destroyed only after the search
+		root = eraseNode(root, key, removed);
+
+		if (root != nil) {
+			slot(root).red = 0;
+		}
+
+		destroyNode(removed);
+		tree_size = tree_size - 1;
+	}
+
+	// longest root-to-leaf path, by an explicit stack of (node, depth)
+	template <typename T, typename compare_type, typename alloc_type>
+	size_t compact_bst<T, compare_type, alloc_type>::height() const {
+
+		std::pair<uint32_t, size_t> stack[max_depth]; // right children still to visit
+		size_t top = 0; // entries on the stack
+		size_t longest = 0; // deepest level seen
+
+		if (root != nil) {
+			stack[top++] = { root, 1 };
+		}
+
+		while (top) {
+
+			auto [n, d] = stack[--top]; // walk down the left spine from here
+
+			for (; n != nil; n = slot(n).left, d = d + 1) {
+
+				longest = d > longest ? d : longest;
+
+				if (slot(n).right != nil) {
+					stack[top++] = { uint32_t(slot(n).right), d + 1 };
+				}
+			}
+		}
+
+		return longest;
+	}
+
+	// destroy every element and return every chunk
+	template <typename T, typename compare_type, typename alloc_type>
+	void compact_bst<T, compare_type, alloc_type>::clear() {
+
+		if constexpr (!std::is_trivially_destructible<T>::value) {
+			destroyTree(root);
+		}
+
+		for (node* c : chunks) {
+			node_traits::deallocate(alloc, c, chunk_size);
+		}
+
+		chunks.clear();
+		root = nil;
+		tree_size = 0;
+		free_head = nil;
+		used = 0;
+	}
+
+	// take the most recently freed slot, else the next untouched one
+	template <typename T, typename compare_type, typename alloc_type>
+	template <typename... Types>
+	uint32_t compact_bst<T, compare_type, alloc_type>::createNode(Types&&... args) {
+
+		uint32_t i = free_head; // slot to construct in
+
+		if (i == nil) { // no freed slot to reuse
+
+			if (used == nil) { // every index below the null link is taken
+				throw std::length_error("compact_bst: more than 2^31 - 1 nodes");
+			}
+
+			if (used == chunks.size() * chunk_size) { // newest chunk is used up
+
+				chunks.reserve(chunks.size() + 1); // so push_back cannot throw after allocating
+				chunks.push_back(node_traits::allocate(alloc, chunk_size));
+			}
+
+			node_traits::construct(alloc, &slot(used), std::forward<Types>(args)...);
+			return used++;
+		}
+
+		free_head = reinterpret_cast<free_slot*>(&slot(i))->next; // valid only until construction
+		uint32_t next = free_head; // put back if T's constructor throws
+
+		try {
+			node_traits::construct(alloc, &slot(i), std::forward<Types>(args)...);
+		}
+		catch (...) {
+			::new (static_cast<void*>(&slot(i))) free_slot{ next };
+			free_head = i;
+			throw;
+		}
+
+		return i;
+	}
+
+	// destroy a node and push its slot onto the free list
+	template <typename T, typename compare_type, typename alloc_type>
+	void compact_bst<T, compare_type, alloc_type>::destroyNode(uint32_t i) {
+
+		node_traits::destroy(alloc, &slot(i));
+		::new (static_cast<void*>(&slot(i))) free_slot{ free_head };
+		free_head = i;
+	}
+
+	// destroy the elements of a subtree; recursion is bounded by the height
+	template <typename T, typename compare_type, typename alloc_type>
+	void compact_bst<T, compare_type, alloc_type>::destroyTree(uint32_t h) {
+
+		while (h != nil) {
+
+			uint32_t right = slot(h).right; // still to destroy
+			destroyTree(slot(h).left);
+			node_traits::destroy(alloc, &slot(h));
+			h = right;
+		}
+	}
+
+	// copy a subtree of another tree into slots of this one
+	template <typename T, typename compare_type, typename alloc_type>
+	uint32_t compact_bst<T, compare_type, alloc_type>::cloneTree(const compact_bst& src, uint32_t s) {
+
+		if (s == nil) {
+			return nil;
+		}
+
+		uint32_t d = createNode(src.slot(s).value); // clone of s
+		slot(d).red = src.slot(s).red;
+
+		try {
+			uint32_t l = cloneTree(src, src.slot(s).left);
+			slot(d).left = l;
+			uint32_t r = cloneTree(src, src.slot(s).right);
+			slot(d).right = r;
+		}
+		catch (...) { // not yet linked to the copy's root: destroy it here
+			destroyTree(d);
+			throw;
+		}
+
+		return d;
+	}
+
+	// plain descent
+	template <typename T, typename compare_type, typename alloc_type>
+	template <typename K>
+	uint32_t compact_bst<T, compare_type, alloc_type>::findIndex(const K& key) const {
+
+		uint32_t n = root; // current node
+		uint32_t candidate = nil; // last node key was not less than
+
+		// one comparison per level: go left if key < value, else right
+		while (n != nil) {
+
+			if (pred(key, slot(n).value)) { // key in left subtree
+				n = slot(n).left;
+			}
+			else { // key not less than value
+				candidate = n;
+				n = slot(n).right;
+			}
+		}
+
+		// key is equivalent to candidate if candidate is not less than key
+		if (candidate != nil && !pred(slot(candidate).value, key)) {
+			return candidate;
+		}
+
+		return nil;
+	}
+
+	// descent recording the path
+	template <typename T, typename compare_type, typename alloc_type>
+	template <typename K>
+	typename compact_bst<T, compare_type, alloc_type>::iterator
+		compact_bst<T, compare_type, alloc_type>::findKey(const K& key) const {
+
+		iterator it(this); // path of the descent
+
+		for (uint32_t n = root; n != nil; ) {
+
+			it.path[it.depth++] = n;
+
+			if (pred(key, slot(n).value)) { // key in left subtree
+				n = slot(n).left;
+			}
+			else if (pred(slot(n).value, key)) { // key in right subtree
+				n = slot(n).right;
+			}
+			else { // equivalent
+				return it;
+			}
+		}
+
+		return iterator(this);
+	}
+
+	// one descent that builds the node at the leaf and the iterator's path on the way back up
+	template <typename T, typename compare_type, typename alloc_type>
+	template <typename... Types>
+	std::pair<typename compact_bst<T, compare_type, alloc_type>::iterator, bool>
+		compact_bst<T, compare_type, alloc_type>::insertValue(const T& key, uint32_t n, Types&&... args) {
+
+		uint32_t found = nil; // equivalent node, if any
+		iterator it(this); // path to the new or equivalent node, bottom-up until reversed
+
+		root = insertNode(root, key, n, found, it, std::forward<Types>(args)...);
+		slot(root).red = 0;
+		std::reverse(it.path, it.path + it.depth);
+
+		if (found != nil) { // n is only set here if emplace built it
+			if (n != nil) {
+				destroyNode(n);
+			}
+			return { it, false };
+		}
+
+		tree_size = tree_size + 1;
+		return { it, true };
+	}
+
+	// recursive left-leaning red-black insert; the depth is bounded by the height
+	template <typename T, typename compare_type, typename alloc_type>
+	template <typename... Types>
+	uint32_t compact_bst<T, compare_type, alloc_type>::insertNode(uint32_t h, const T& key, uint32_t& n,
+		uint32_t& found, iterator& trail, Types&&... args) {
+
+		if (h == nil) { // insertion point: nothing has been modified yet if this throws
+			if (n == nil) {
+				n = createNode(std::forward<Types>(args)...);
+			}
+			trail.path[0] = n;
+			trail.depth = 1;
+			return n;
+		}
+
+		if (pred(key, slot(h).value)) { // insert into left subtree
+			uint32_t l = insertNode(slot(h).left, key, n, found, trail, std::forward<Types>(args)...);
+			slot(h).left = l;
+		}
+		else if (pred(slot(h).value, key)) { // insert into right subtree
+			uint32_t r = insertNode(slot(h).right, key, n, found, trail, std::forward<Types>(args)...);
+			slot(h).right = r;
+		}
+		else { // equivalent element present
+			found = h;
+			trail.path[0] = h;
+			trail.depth = 1;
+			return h;
+		}
+
+		trail.path[trail.depth++] = h;
+		return balance(h, &trail);
+	}
+
+	// recursive top-down left-leaning red-black erase (Sedgewick)
+	template <typename T, typename compare_type, typename alloc_type>
+	template <typename K>
+	uint32_t compact_bst<T, compare_type, alloc_type>::eraseNode(uint32_t h, const K& key, uint32_t& removed) {
+
+		if (pred(key, slot(h).value)) { // key in left subtree
+
+			if (!isRed(slot(h).left) && !isRed(slot(slot(h).left).left)) {
+				h = moveRedLeft(h);
+			}
+
+			uint32_t l = eraseNode(slot(h).left, key, removed);
+			slot(h).left = l;
+			return balance(h);
+		}
+
+		if (isRed(slot(h).left)) { // lean right so the key's side can lend a red link
+			h = rotateRight(h);
+		}
+
+		// key is never less than h here, so not greater means equivalent
+		if (!pred(slot(h).value, key) && slot(h).right == nil) { // a leaf
+			removed = h;
+			return nil;
+		}
+
+		if (!isRed(slot(h).right) && !isRed(slot(slot(h).right).left)) {
+			h = moveRedRight(h);
+		}
+
+		if (!pred(slot(h).value, key)) { // replace h by its successor, relinked rather than copied
+
+			uint32_t successor = nil; // leftmost node of the right subtree
+			uint32_t r = eraseMin(slot(h).right, successor);
+
+			slot(successor).left = slot(h).left;
+			slot(successor).right = r;
+			slot(successor).red = slot(h).red;
+
+			removed = h;
+			h = successor;
+		}
+		else { // key in right subtree
+			uint32_t r = eraseNode(slot(h).right, key, removed);
+			slot(h).right = r;
+		}
+
+		return balance(h);
+	}
+
+	// remove the leftmost node of a subtree, handing it back unlinked
+	template <typename T, typename compare_type, typename alloc_type>
+	uint32_t compact_bst<T, compare_type, alloc_type>::eraseMin(uint32_t h, uint32_t& min) {
+
+		if (slot(h).left == nil) { // leftmost node (no right child in a left-leaning tree)
+			min = h;
+			return nil;
+		}
+
+		if (!isRed(slot(h).left) && !isRed(slot(slot(h).left).left)) {
+			h = moveRedLeft(h);
+		}
+
+		uint32_t l = eraseMin(slot(h).left, min);
+		slot(h).left = l;
+		return balance(h);
+	}
+
+	// lift right child of h into its place
+	template <typename T, typename compare_type, typename alloc_type>
+	uint32_t compact_bst<T, compare_type, alloc_type>::rotateLeft(uint32_t h) {
+
+		uint32_t x = slot(h).right; // new subtree root
+
+		slot(h).right = slot(x).left;
+		slot(x).left = h;
+		slot(x).red = slot(h).red;
+		slot(h).red = 1;
+
+		return x;
+	}
+
+	// lift left child of h into its place
+	template <typename T, typename compare_type, typename alloc_type>
+	uint32_t compact_bst<T, compare_type, alloc_type>::rotateRight(uint32_t h) {
+
+		uint32_t x = slot(h).left; // new subtree root
+
+		slot(h).left = slot(x).right;
+		slot(x).right = h;
+		slot(x).red = slot(h).red;
+		slot(h).red = 1;
+
+		return x;
+	}
+
+	// split or merge a 4-node
+	template <typename T, typename compare_type, typename alloc_type>
+	void compact_bst<T, compare_type, alloc_type>::flipColors(uint32_t h) {
+
+		slot(h).red = !slot(h).red;
+		slot(slot(h).left).red = !slot(slot(h).left).red;
+		slot(slot(h).right).red = !slot(slot(h).right).red;
+	}
+
+	// borrow from the right sibling so the left child is not a 2-node
+	template <typename T, typename compare_type, typename alloc_type>
+	uint32_t compact_bst<T, compare_type, alloc_type>::moveRedLeft(uint32_t h) {
+
+		flipColors(h);
+
+		if (isRed(slot(slot(h).right).left)) {
+			uint32_t r = rotateRight(slot(h).right);
+			slot(h).right = r;
+			h = rotateLeft(h);
+			flipColors(h);
+		}
+
+		return h;
+	}
+
+	// borrow from the left sibling so the right child is not a 2-node
+	template <typename T, typename compare_type, typename alloc_type>
+	uint32_t compact_bst<T, compare_type, alloc_type>::moveRedRight(uint32_t h) {
+
+		flipColors(h);
+
+		if (isRed(slot(slot(h).left).left)) {
+			h = rotateRight(h);
+			flipColors(h);
+		}
+
+		return h;
+	}
+
+	// fix right-leaning red links, two reds in a row, and 4-nodes on the way up
+	template <typename T, typename compare_type, typename alloc_type>
+	uint32_t compact_bst<T, compare_type, alloc_type>::balance(uint32_t h, iterator* trail) {
+
+		if (isRed(slot(h).right) && !isRed(slot(h).left)) {
+			h = rotateLeft(h);
+			if (trail) {
+				liftTrail(h, *trail);
+			}
+		}
+
+		if (isRed(slot(h).left) && isRed(slot(slot(h).left).left)) {
+			h = rotateRight(h);
+			if (trail) {
+				liftTrail(h, *trail);
+			}
+		}
+
+		if (isRed(slot(h).left) && isRed(slot(h).right)) {
+			flipColors(h);
+		}
+
+		return h;
+	}
+
+	// the trail ends at the old top h, now a child of x; only the nodes
+	// between the two levels change, so no comparison is needed
+	template <typename T, typename compare_type, typename alloc_type>
+	void compact_bst<T, compare_type, alloc_type>::liftTrail(uint32_t x, iterator& trail) const {
+
+		uint32_t* p = trail.path; // bottom-up: p[0] is the target
+		size_t d = trail.depth; // p[d - 1] is the old top
+		uint32_t h = p[d - 1]; // old top
+
+		if (d < 2 || p[d - 2] != x) { // target is h or on h's far side: x goes on top
+			p[d] = x;
+			trail.depth = d + 1;
+		}
+		else if (d >= 3 && (p[d - 3] == slot(h).left || p[d - 3] == slot(h).right)) { // x's inner child moved under h
+			p[d - 2] = h;
+			p[d - 1] = x;
+		}
+		else { // target is x or on x's outer side: h drops out
+			trail.depth = d - 1;
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,951 @@
+#ifndef CONCURRENT_BST_H
+#define CONCURRENT_BST_H
+
+#include <utility>
+#include <functional>
+#include <iterator>
+#include <type_traits>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <random>
+
+#include "bst.h"
+
+namespace binarysearch {
+
+	/**
+	* epoch-based reclamation: a reader pins the current epoch in a slot of
+	* its own for as long as it may hold node pointers, and a writer tags
+	* what it unlinks with the epoch it advances past; anything tagged
+	* below the oldest pinned epoch can no longer be reached by a reader
+	* slots come in blocks of max_readers; when every slot is pinned another
+	* block is appended, so a pin never waits for another to be released
+	* (nested pins, such as contains() while holding a snapshot, are safe)
+	*/
+	class epoch_domain {
+
+	public:
+
+		/**
+		* constructor which starts at epoch 0 with every slot idle
+		*/
+		epoch_domain();
+
+		/**
+		* destructor which frees the appended blocks of slots
+		*/
+		~epoch_domain();
+
+		epoch_domain(const epoch_domain&) = delete;
+		epoch_domain& operator=(const epoch_domain&) = delete;
+
+		/**
+		* pins the current epoch, starting from the calling thread's own slot
+		* and appending a block of slots if every slot is pinned
+		* @return the slot to pass to unpin
+		*/
+		size_t pin();
+
+		/**
+		* releases a pin
+		* @param slot slot returned by pin
+		*/
+		void unpin(size_t slot);
+
+		/**
+		* moves to the next epoch; call after unlinking nodes
+		* @return the epoch the unlinked nodes are tagged with
+		*/
+		uint64_t advance();
+
+		/**
+		* oldest epoch a reader is still pinned in
+		* @return that epoch, or idle if no reader is pinned
+		*/
+		uint64_t oldest() const;
+
+		static constexpr size_t max_readers = 128; // slots per block
+		static constexpr uint64_t idle = UINT64_MAX; // value of an unpinned slot
+
+	private:
+		struct alignas(64) slot_type { std::atomic<uint64_t> epoch; }; // one cache line per reader
+
+		struct slot_block { // max_readers slots, chained; blocks are only freed with the domain
+
+			slot_block();
+
+			slot_type slots[max_readers]; // pinned epoch of each reader
+			std::atomic<slot_block*> next; // block appended after this one, or null
+		};
+
+		static size_t homeSlot(); // first slot the calling thread tries
+
+		alignas(64) std::atomic<uint64_t> current; // global epoch
+		slot_block first; // slots every domain has
+	};
+
+	// every slot starts idle
+	inline epoch_domain::slot_block::slot_block() : next(nullptr) {
+		for (slot_type& s : slots) {
+			s.epoch.store(idle);
+		}
+	}
+
+	// starts at epoch 0
+	inline epoch_domain::epoch_domain() : current(0) {}
+
+	// free the appended blocks
+	inline epoch_domain::~epoch_domain() {
+
+		for (slot_block* b = first.next.load(); b; ) {
+			slot_block* next = b->next.load(); // read before b is freed
+			delete b;
+			b = next;
+		}
+	}
+
+	// pin the current epoch in a free slot, appending a block when all are pinned
+	inline size_t epoch_domain::pin() {
+
+		size_t home = homeSlot(); // spreads threads across slots
+
+		size_t base = 0; // index of b's first slot
+
+		for (slot_block* b = &first; ; base = base + max_readers) {
+
+			for (size_t tries = 0; tries < max_readers; ++tries) {
+
+				size_t i = (home + tries) % max_readers; // slot to try
+
+				uint64_t expected = idle; // only claim an idle slot
+				if (b->slots[i].epoch.load(std::memory_order_relaxed) == idle &&
+					b->slots[i].epoch.compare_exchange_strong(expected, current.load())) {
+					return base + i;
+				}
+			}
+
+			slot_block* next = b->next.load(); // block after this one, if any
+
+			if (!next) { // every slot pinned: append a block, or take the one another reader appended
+
+				slot_block* grown = new slot_block();
+
+				if (b->next.compare_exchange_strong(next, grown)) {
+					next = grown;
+				}
+				else {
+					delete grown;
+				}
+			}
+
+			b = next;
+		}
+	}
+
+	// release a pin
+	inline void epoch_domain::unpin(size_t slot) {
+
+		slot_block* b = &first; // block holding the slot
+		for (; slot >= max_readers; slot = slot - max_readers) {
+			b = b->next.load();
+		}
+
+		b->slots[slot].epoch.store(idle, std::memory_order_release);
+	}
+
+	// move to the next epoch
+	inline uint64_t epoch_domain::advance() {
+		return current.fetch_add(1);
+	}
+
+	// smallest pinned epoch
+	inline uint64_t epoch_domain::oldest() const {
+
+		uint64_t low = idle; // nothing pinned yet
+
+		for (const slot_block* b = &first; b; b = b->next.load()) {
+			for (const slot_type& s : b->slots) {
+
+				uint64_t e = s.epoch.load(); // pinned epoch or idle
+				low = e < low ? e : low;
+			}
+		}
+
+		return low;
+	}
+
+	// threads take consecutive home slots in the order they first pin
+	inline size_t epoch_domain::homeSlot() {
+
+		static std::atomic<size_t> threads(0); // threads seen so far
+		thread_local size_t home = threads.fetch_add(1) % max_readers;
+		return home;
+	}
+
+	/**
+	* templated sorted set for read-mostly concurrent use
+	* readers never lock: they pin an epoch, load the root and walk nodes
+	* that are never modified once published; writers take a mutex, copy the
+	* path they change (a treap, so only O(log n) expected nodes are copied)
+	* and publish the new root in one atomic store; replaced nodes are freed
+	* once no pinned reader can still reach them
+	* T must be copy constructible; elements are reached through a snapshot
+	* @param T the data type of the tree
+	* @param compare_type the comparison function to compare the data
+	*/
+	template <typename T, typename compare_type = std::less<T>>
+	class concurrent_bst {
+
+		struct node; // immutable once published
+
+	public:
+
+		/**
+		* iterator class declaration
+		*/
+		class iterator;
+
+		/**
+		* snapshot class declaration
+		*/
+		class snapshot;
+
+		/**
+		* constructor which initializes an empty tree
+		* @param pred_input the comparison function to compare the data
+		*/
+		concurrent_bst(const compare_type& pred_input = compare_type()) :
+			pred(pred_input), root(nullptr), tree_size(0) {}
+
+		/**
+		* destructor which frees every node; no reader may still be active
+		*/
+		~concurrent_bst();
+
+		concurrent_bst(const concurrent_bst&) = delete;
+		concurrent_bst& operator=(const concurrent_bst&) = delete;
+
+		/**
+		* checks if the tree contains a particular element, without locking
+		* @param item the type T element to look for
+		* @return whether an equivalent element is present
+		*/
+		bool contains(const T& item) const;
+
+		/**
+		* checks if the tree contains an element equivalent to key, without
+		* locking (only with a transparent comparator)
+		* @param key value comparable with T through compare_type
+		* @return whether an equivalent element is present
+		*/
+		template <typename K, typename C = compare_type,
+			typename = std::enable_if_t<detail::is_transparent<C>::value>>
+		bool contains(const K& key) const;
+
+		/**
+		* pins the current version for lock-free finds and iteration; writes
+		* made after this call are not seen through the snapshot, and a thread
+		* may hold any number of snapshots while it reads or pins again
+		* @return snapshot of the tree
+		*/
+		snapshot read() const;
+
+		/**
+		* adds given lvalue to the tree
+		* @param value the element to be added
+		* @return whether value was inserted (false if it was already present)
+		*/
+		bool insert(const T& value);
+
+		/**
+		* adds given rvalue to the tree
+		* @param value the element to be added
+		* @return whether value was inserted (false if it was already present)
+		*/
+		bool insert(T&& value);
+
+		/**
+		* removes the element equivalent to a value
+		* @param item the type T element to remove
+		* @return number of elements removed (0 or 1)
+		*/
+		size_t erase(const T& item);
+
+		/**
+		* removes the element equivalent to key (only with a transparent comparator)
+		* @param key value comparable with T through compare_type
+		* @return number of elements removed (0 or 1)
+		*/
+		template <typename K, typename C = compare_type,
+			typename = std::enable_if_t<detail::is_transparent<C>::value>>
+		size_t erase(const K& key);
+
+		/**
+		* accessor to the number of elements in the newest version
+		* @return number of elements
+		*/
+		size_t size() const { return tree_size.load(); }
+
+		/**
+		* removes every element
+		*/
+		void clear();
+
+	private:
+		compare_type pred; // comparison function to compare the data
+		std::atomic<node*> root; // newest published version
+		std::atomic<size_t> tree_size; // number of elements in the newest version
+		mutable epoch_domain epochs; // pins of active readers
+
+		std::mutex writer; // serializes writers; readers never take it
+		std::minstd_rand priorities; // treap priorities, drawn under writer
+		std::vector<std::pair<uint64_t, node*>> retired; // unlinked nodes with their epoch tag
+		std::vector<node*> fresh; // nodes created by the current write
+		std::vector<node*> replaced; // nodes the current write unlinks
+
+		// node equivalent to key in the subtree of n, or null
+		template <typename K>
+		const node* findNode(const node*, const K&) const;
+
+		// copy of n recorded as fresh, with n recorded as replaced
+		node* clone(const node*);
+
+		// subtree of n with value added (n itself if an equivalent is present)
+		template <typename V>
+		node* insertNode(node*, V&&);
+
+		// subtree of n without key (n itself if key is absent)
+		template <typename K>
+		node* eraseNode(node*, const K&);
+
+		// subtrees a and b, every element of a less than b's, joined into one
+		node* joinNodes(node*, node*);
+
+		template <typename V>
+		bool insertValue(V&&); // insert under the writer lock
+
+		template <typename K>
+		size_t eraseKey(const K&); // erase under the writer lock
+
+		void publish(node*); // store a new root and retire replaced nodes
+		void rollback(); // free fresh nodes after a throwing write
+		void reclaim(); // free retired nodes no reader can reach
+		static void destroyTree(node*); // free a whole subtree
+	};
+
+	//nested node definition
+	template <typename T, typename compare_type>
+	struct concurrent_bst<T, compare_type>::node {
+
+		/**
+		* constructor which initializes value, left, right, and priority
+		*/
+		template <typename V>
+		node(V&& v, node* l, node* r, uint32_t p) :
+			value(std::forward<V>(v)), left(l), right(r), priority(p) {}
+
+		const T value; // element held in the node
+		node* left; // left child, fixed once published
+		node* right; // right child, fixed once published
+		uint32_t priority; // heap order of the treap
+	};
+
+	//nested iterator class definition
+	template <typename T, typename compare_type>
+	class concurrent_bst<T, compare_type>::iterator { //nested iterator class
+
+		friend concurrent_bst; //to allow iterator construction by snapshot operations
+
+		public:
+
+		// standard iterator traits (forward, read-only)
+		using iterator_category = std::forward_iterator_tag;
+		using value_type = T;
+		using difference_type = std::ptrdiff_t;
+		using pointer = const T*;
+		using reference = const T&;
+
+		/**
+		* overloaded prefix ++
+		*/
+		iterator& operator++() {
+
+			const node* n = path.back()->right; // successor is in the right subtree, if any
+			path.pop_back();
+
+			for (; n; n = n->left) { // or the nearest ancestor went left from
+				path.push_back(n);
+			}
+
+			return *this;
+		}
+
+		/**
+		* overloaded postfix ++
+		*/
+		iterator operator++(int) {
+
+			auto copy(*this); // copy of current position
+			++(*this);
+			return copy;
+		}
+
+		/**
+		* overloaded == comparison operator
+		*/
+		friend bool operator==(const iterator& left, const iterator& right) {
+			return left.current() == right.current();
+		}
+
+		/**
+		* overloaded != comparison operator
+		*/
+		friend bool operator!=(const iterator& left, const iterator& right) {
+			return left.current() != right.current();
+		}
+
+		/**
+		* overload dereferencing operator
+		*/
+		const T& operator*() const {
+			return path.back()->value;
+		}
+
+		/**
+		* overload the operator arrow
+		*/
+		const T* operator->() const {
+			return &path.back()->value;
+		}
+
+	private:
+
+		/**
+		* constructor which initializes an empty path (end)
+		*/
+		iterator() {}
+
+		const node* current() const { return path.empty() ? nullptr : path.back(); } // null at end
+
+		std::vector<const node*> path; // current node on top, below it the ancestors still to visit
+	};
+
+	//nested snapshot class definition
+	template <typename T, typename compare_type>
+	class concurrent_bst<T, compare_type>::snapshot { //nested snapshot class
+
+		friend concurrent_bst; //to allow snapshot construction by read
+
+		public:
+
+		/**
+		* move constructor
+		* @param that rvalue reference to move-from snapshot
+		*/
+		snapshot(snapshot&& that) noexcept :
+			container(that.container), slot(that.slot), root(that.root) {
+			that.container = nullptr;
+		}
+
+		snapshot(const snapshot&) = delete;
+		snapshot& operator=(const snapshot&) = delete;
+
+		/**
+		* destructor which unpins the version; its iterators become invalid
+		*/
+		~snapshot() {
+			if (container) {
+				container->epochs.unpin(slot);
+			}
+		}
+
+		/**
+		* checks if the snapshot contains a particular element
+		* @param item the type T element to look for
+		* @return iterator to the element
+		*/
+		iterator find(const T& item) const { return findIterator(item); }
+
+		/**
+		* checks if the snapshot contains an element equivalent to key
+		* (only with a transparent comparator)
+		* @param key value comparable with T through compare_type
+		* @return iterator to the element
+		*/
+		template <typename K, typename C = compare_type,
+			typename = std::enable_if_t<detail::is_transparent<C>::value>>
+		iterator find(const K& key) const { return findIterator(key); }
+
+		/**
+		* checks if the snapshot contains a particular element
+		* @param item the type T element to look for
+		* @return whether an equivalent element is present
+		*/
+		bool contains(const T& item) const { return container->findNode(root, item) != nullptr; }
+
+		/**
+		* first element not less than a value
+		* @param item the type T bound
+		* @return iterator to that element, or end()
+		*/
+		iterator lower_bound(const T& item) const;
+
+		/**
+		* returns an iterator to the "smallest" element
+		* @return iterator to the leftmost node
+		*/
+		iterator begin() const;
+
+		/**
+		* returns an iterator to past-the-end position
+		* @return iterator with an empty path
+		*/
+		iterator end() const { return iterator(); }
+
+	private:
+
+		/**
+		* constructor which pins the newest version of c
+		* @param c the container read from
+		*/
+		snapshot(const concurrent_bst* c) : container(c), slot(c->epochs.pin()), root(c->root.load()) {}
+
+		// iterator to the node equivalent to key, or end()
+		template <typename K>
+		iterator findIterator(const K&) const;
+
+		const concurrent_bst* container; // container read from (null once moved from)
+		size_t slot; // epoch pin held for the snapshot's lifetime
+		const node* root; // root of the pinned version
+	};
+
+	// free every node
+	template <typename T, typename compare_type>
+	concurrent_bst<T, compare_type>::~concurrent_bst() {
+
+		destroyTree(root.load());
+
+		for (auto& r : retired) { // replaced nodes are freed one by one
+			delete r.second;
+		}
+	}
+
+	// lock-free membership check
+	template <typename T, typename compare_type>
+	bool concurrent_bst<T, compare_type>::contains(const T& item) const {
+		return read().contains(item);
+	}
+
+	// lock-free membership check of a key
+	template <typename T, typename compare_type>
+	template <typename K, typename C, typename>
+	bool concurrent_bst<T, compare_type>::contains(const K& key) const {
+
+		snapshot s = read(); // pins the version for the descent
+		return findNode(s.root, key) != nullptr;
+	}
+
+	// pin the newest version
+	template <typename T, typename compare_type>
+	typename concurrent_bst<T, compare_type>::snapshot concurrent_bst<T, compare_type>::read() const {
+		return snapshot(this);
+	}
+
+	// insert lvalue
+	template <typename T, typename compare_type>
+	bool concurrent_bst<T, compare_type>::insert(const T& value) {
+		return insertValue(value);
+	}
+
+	// insert rvalue
+	template <typename T, typename compare_type>
+	bool concurrent_bst<T, compare_type>::insert(T&& value) {
+		return insertValue(std::move(value));
+	}
+
+	// erase by value
+	template <typename T, typename compare_type>
+	size_t concurrent_bst<T, compare_type>::erase(const T& item) {
+		return eraseKey(item);
+	}
+
+	// erase by key
+	template <typename T, typename compare_type>
+	template <typename K, typename C, typename>
+	size_t concurrent_bst<T, compare_type>::erase(const K& key) {
+		return eraseKey(key);
+	}
+
+	// publish an empty version and retire every node of the old one
+	template <typename T, typename compare_type>
+	void concurrent_bst<T, compare_type>::clear() {
+
+		std::lock_guard<std::mutex> lock(writer);
+
+		try {
+
+			std::vector<node*> stack; // nodes still to record
+			if (root.load()) {
+				stack.push_back(root.load());
+			}
+
+			while (!stack.empty()) {
+
+				node* n = stack.back();
+				stack.pop_back();
+				replaced.push_back(n);
+
+				if (n->left) {
+					stack.push_back(n->left);
+				}
+				if (n->right) {
+					stack.push_back(n->right);
+				}
+			}
+		}
+		catch (...) {
+			rollback();
+			throw;
+		}
+
+		publish(nullptr);
+		tree_size.store(0);
+	}
+
+	// plain descent; published nodes never change
+	template <typename T, typename compare_type>
+	template <typename K>
+	const typename concurrent_bst<T, compare_type>::node* concurrent_bst<T, compare_type>::findNode(const node* n, const K& key) const {
+
+		while (n) {
+
+			if (pred(key, n->value)) { // key in left subtree
+				n = n->left;
+			}
+			else if (pred(n->value, key)) { // key in right subtree
+				n = n->right;
+			}
+			else { // equivalent
+				return n;
+			}
+		}
+
+		return nullptr;
+	}
+
+	// copy a published node the write is about to change
+	template <typename T, typename compare_type>
+	typename concurrent_bst<T, compare_type>::node* concurrent_bst<T, compare_type>::clone(const node* n) {
+
+		fresh.push_back(nullptr); // reserve the slot first so a throwing push_back leaks nothing
+		fresh.back() = new node(n->value, n->left, n->right, n->priority);
+		replaced.push_back(const_cast<node*>(n));
+		return fresh.back();
+	}
+
+	// path-copying treap insert; rotations only touch fresh nodes
+	template <typename T, typename compare_type>
+	template <typename V>
+	typename concurrent_bst<T, compare_type>::node* concurrent_bst<T, compare_type>::insertNode(node* n, V&& value) {
+
+		if (!n) { // insertion point
+			fresh.push_back(nullptr);
+			fresh.back() = new node(std::forward<V>(value), nullptr, nullptr, static_cast<uint32_t>(priorities()));
+			return fresh.back();
+		}
+
+		if (pred(value, n->value)) { // insert into left subtree
+
+			node* l = insertNode(n->left, std::forward<V>(value));
+			if (l == n->left) { // already present
+				return n;
+			}
+
+			node* c = clone(n);
+			c->left = l;
+
+			if (l->priority > c->priority) { // rotate right
+				c->left = l->right;
+				l->right = c;
+				return l;
+			}
+
+			return c;
+		}
+
+		if (pred(n->value, value)) { // insert into right subtree
+
+			node* r = insertNode(n->right, std::forward<V>(value));
+			if (r == n->right) { // already present
+				return n;
+			}
+
+			node* c = clone(n);
+			c->right = r;
+
+			if (r->priority > c->priority) { // rotate left
+				c->right = r->left;
+				r->left = c;
+				return r;
+			}
+
+			return c;
+		}
+
+		return n; // equivalent element present
+	}
+
+	// path-copying erase; the erased node's children are joined in its place
+	template <typename T, typename compare_type>
+	template <typename K>
+	typename concurrent_bst<T, compare_type>::node* concurrent_bst<T, compare_type>::eraseNode(node* n, const K& key) {
+
+		if (!n) { // key absent
+			return nullptr;
+		}
+
+		if (pred(key, n->value)) { // erase from left subtree
+
+			node* l = eraseNode(n->left, key);
+			if (l == n->left) { // nothing erased
+				return n;
+			}
+
+			node* c = clone(n);
+			c->left = l;
+			return c;
+		}
+
+		if (pred(n->value, key)) { // erase from right subtree
+
+			node* r = eraseNode(n->right, key);
+			if (r == n->right) { // nothing erased
+				return n;
+			}
+
+			node* c = clone(n);
+			c->right = r;
+			return c;
+		}
+
+		replaced.push_back(n);
+		return joinNodes(n->left, n->right);
+	}
+
+	// join along the right spine of a and the left spine of b, by priority
+	template <typename T, typename compare_type>
+	typename concurrent_bst<T, compare_type>::node* concurrent_bst<T, compare_type>::joinNodes(node* a, node* b) {
+
+		if (!a) {
+			return b;
+		}
+		if (!b) {
+			return a;
+		}
+
+		if (a->priority > b->priority) { // a stays on top
+
+			node* c = clone(a);
+			c->right = joinNodes(a->right, b);
+			return c;
+		}
+
+		node* c = clone(b); // b stays on top
+		c->left = joinNodes(a, b->left);
+		return c;
+	}
+
+	// insert under the writer lock
+	template <typename T, typename compare_type>
+	template <typename V>
+	bool concurrent_bst<T, compare_type>::insertValue(V&& value) {
+
+		std::lock_guard<std::mutex> lock(writer);
+
+		node* old_root = root.load(); // writers are serialized, so this is the newest version
+		node* new_root;
+
+		try {
+			new_root = insertNode(old_root, std::forward<V>(value));
+		}
+		catch (...) {
+			rollback();
+			throw;
+		}
+
+		if (new_root == old_root) { // already present
+			return false;
+		}
+
+		publish(new_root);
+		tree_size.fetch_add(1);
+		return true;
+	}
+
+	// erase under the writer lock
+	template <typename T, typename compare_type>
+	template <typename K>
+	size_t concurrent_bst<T, compare_type>::eraseKey(const K& key) {
+
+		std::lock_guard<std::mutex> lock(writer);
+
+		node* old_root = root.load(); // writers are serialized, so this is the newest version
+		node* new_root;
+
+		try {
+			new_root = eraseNode(old_root, key);
+		}
+		catch (...) {
+			rollback();
+			throw;
+		}
+
+		if (new_root == old_root) { // key absent
+			return 0;
+		}
+
+		publish(new_root);
+		tree_size.fetch_sub(1);
+		return 1;
+	}
+
+	// make a new version visible; what it replaced is retired, not freed
+	template <typename T, typename compare_type>
+	void concurrent_bst<T, compare_type>::publish(node* new_root) {
+
+		try {
+			retired.reserve(retired.size() + replaced.size()); // so retiring below cannot throw
+		}
+		catch (...) {
+			rollback();
+			throw;
+		}
+
+		root.store(new_root);
+
+		// readers that loaded the old root pinned an epoch no later than this tag
+		uint64_t tag = epochs.advance();
+
+		for (node* n : replaced) {
+			retired.push_back({ tag, n });
+		}
+
+		fresh.clear();
+		replaced.clear();
+		reclaim();
+	}
+
+	// undo the allocations of a write that threw before publishing
+	template <typename T, typename compare_type>
+	void concurrent_bst<T, compare_type>::rollback() {
+
+		for (node* n : fresh) {
+			delete n;
+		}
+
+		fresh.clear();
+		replaced.clear();
+	}
+
+	// free retired nodes tagged before every pinned reader
+	template <typename T, typename compare_type>
+	void concurrent_bst<T, compare_type>::reclaim() {
+
+		uint64_t oldest = epochs.oldest(); // readers pinned since hold no older nodes
+		size_t freed = 0; // tags only grow, so freeable nodes form a prefix
+
+		for (; freed < retired.size() && retired[freed].first < oldest; ++freed) {
+			delete retired[freed].second;
+		}
+
+		retired.erase(retired.begin(), retired.begin() + freed);
+	}
+
+	// free a subtree with an explicit stack
+	template <typename T, typename compare_type>
+	void concurrent_bst<T, compare_type>::destroyTree(node* n) {
+
+		std::vector<node*> stack; // nodes still to free
+		if (n) {
+			stack.push_back(n);
+		}
+
+		while (!stack.empty()) {
+
+			node* top = stack.back();
+			stack.pop_back();
+
+			if (top->left) {
+				stack.push_back(top->left);
+			}
+			if (top->right) {
+				stack.push_back(top->right);
+			}
+
+			delete top;
+		}
+	}
+
+	// descend to key, keeping the ancestors the path went left from
+	template <typename T, typename compare_type>
+	template <typename K>
+	typename concurrent_bst<T, compare_type>::iterator concurrent_bst<T, compare_type>::snapshot::findIterator(const K& key) const {
+
+		iterator it; // path of the descent
+
+		for (const node* n = root; n; ) {
+
+			if (container->pred(key, n->value)) { // key in left subtree
+				it.path.push_back(n);
+				n = n->left;
+			}
+			else if (container->pred(n->value, key)) { // key in right subtree
+				n = n->right;
+			}
+			else { // equivalent
+				it.path.push_back(n);
+				return it;
+			}
+		}
+
+		return iterator();
+	}
+
+	// first element not less than a value
+	template <typename T, typename compare_type>
+	typename concurrent_bst<T, compare_type>::iterator concurrent_bst<T, compare_type>::snapshot::lower_bound(const T& item) const {
+
+		iterator it; // every node not less than item on the path; the last is the bound
+
+		for (const node* n = root; n; ) {
+
+			if (!container->pred(n->value, item)) { // value not less than item
+				it.path.push_back(n);
+				n = n->left;
+			}
+			else { // value less than item
+				n = n->right;
+			}
+		}
+
+		return it;
+	}
+
+	// leftmost node, with its ancestors on the path
+	template <typename T, typename compare_type>
+	typename concurrent_bst<T, compare_type>::iterator concurrent_bst<T, compare_type>::snapshot::begin() const {
+
+		iterator it; // left spine of the pinned version
+
+		for (const node* n = root; n; n = n->left) {
+			it.path.push_back(n);
+		}
+
+		return it;
+	}
+}
+
+#endif
@@ -0,0 +1,467 @@
+#ifndef FROZEN_BST_H
+#define FROZEN_BST_H
+
+#include <utility>
+#include <functional>
+#include <iterator>
+#include <type_traits>
+#include <cstddef>
+#include <vector>
+
+#include "bst.h"
+
+namespace binarysearch {
+
+	/**
+	* immutable snapshot of a sorted set stored in Eytzinger (breadth-first)
+	* order in one contiguous array: the children of slot k are 2k and 2k + 1,
+	* so a search touches one predictable path and the top levels share
+	* cache lines; lookups are branchless and prefetch four levels ahead
+	* @param T the data type of the snapshot
+	* @param compare_type the comparison function to compare the data
+	*/
+	template <typename T, typename compare_type = std::less<T>>
+	class frozen_bst {
+
+	public:
+
+		/**
+		* iterator class declaration
+		*/
+		class iterator;
+
+		/**
+		* constructor which initializes an empty snapshot
+		* @param pred_input the comparison function to compare the data
+		*/
+		frozen_bst(const compare_type& pred_input = compare_type()) : pred(pred_input) {}
+
+		/**
+		* constructor which lays out a range the caller guarantees sorted
+		* and free of equivalents
+		* @param first beginning of the range
+		* @param last end of the range
+		* @param pred_input the comparison function to compare the data
+		*/
+		template <typename InputIt>
+		frozen_bst(sorted_unique_t, InputIt first, InputIt last,
+			const compare_type& pred_input = compare_type());
+
+		/**
+		* checks if the snapshot contains a particular element
+		* @param item the type T element to look for
+		* @return iterator to the element
+		*/
+		iterator find(const T& item) const;
+
+		/**
+		* checks if the snapshot contains an element equivalent to key
+		* (only with a transparent comparator)
+		* @param key value comparable with T through compare_type
+		* @return iterator to the element
+		*/
+		template <typename K, typename C = compare_type,
+			typename = std::enable_if_t<detail::is_transparent<C>::value>>
+		iterator find(const K& key) const;
+
+		/**
+		* counts elements equivalent to a value
+		* @param item the type T element to look for
+		* @return 1 if present, 0 otherwise
+		*/
+		size_t count(const T& item) const;
+
+		/**
+		* checks if the snapshot contains a particular element
+		* @param item the type T element to look for
+		* @return whether an equivalent element is present
+		*/
+		bool contains(const T& item) const;
+
+		/**
+		* first element not less than a value
+		* @param item the type T bound
+		* @return iterator to that element, or end()
+		*/
+		iterator lower_bound(const T& item) const;
+
+		/**
+		* first element greater than a value
+		* @param item the type T bound
+		* @return iterator to that element, or end()
+		*/
+		iterator upper_bound(const T& item) const;
+
+		/**
+		* returns an iterator to the "smallest" element
+		* @return iterator to the leftmost slot
+		*/
+		iterator begin() const;
+
+		/**
+		* returns an iterator to past-the-end position
+		* @return iterator to slot 0
+		*/
+		iterator end() const;
+
+		/**
+		* accessor to the number of elements
+		* @return number of elements
+		*/
+		size_t size() const { return slots.size(); }
+
+	private:
+		compare_type pred; // comparison function to compare the data
+		std::vector<T> slots; // slot k (1-based) is stored at slots[k - 1]
+
+		// slot of the first element not less than key (0 if none), branchless
+		template <typename K>
+		size_t lowerSlot(const K&) const;
+
+		// slot of the first element greater than key (0 if none), branchless
+		template <typename K>
+		size_t upperSlot(const K&) const;
+
+		// slot of the element equivalent to key (0 if none)
+		template <typename K>
+		size_t findSlot(const K&) const;
+
+		static size_t firstSlot(size_t); // leftmost slot of a tree of n slots
+		static size_t lastSlot(size_t); // rightmost slot of a tree of n slots
+		static size_t nextSlot(size_t, size_t); // in-order successor (0 after last)
+		static size_t prevSlot(size_t, size_t); // in-order predecessor (0 before first)
+		void prefetch(size_t) const; // hint the slots four levels below
+	};
+
+	/**
+	* snapshot of a tree's current contents in O(n), without comparisons
+	* @param tree the tree to freeze
+	* @return frozen_bst holding the same elements and comparator
+	*/
+	template <typename T, typename compare_type, typename balance_type, typename alloc_type, bst_options options>
+	frozen_bst<T, compare_type> freeze(const bst<T, compare_type, balance_type, alloc_type, options>& tree) {
+		return frozen_bst<T, compare_type>(sorted_unique, tree.begin(), tree.end(), tree.key_comp());
+	}
+
+	//nested iterator class definition
+	template <typename T, typename compare_type>
+	class frozen_bst<T, compare_type>::iterator { //nested iterator class
+
+		friend frozen_bst; //to allow iterator construction by frozen_bst operations
+
+		public:
+
+		// standard iterator traits (bidirectional, read-only)
+		using iterator_category = std::bidirectional_iterator_tag;
+		using value_type = T;
+		using difference_type = std::ptrdiff_t;
+		using pointer = const T*;
+		using reference = const T&;
+
+		/**
+		* overloaded prefix ++
+		*/
+		iterator& operator++() {
+			slot = nextSlot(slot, container->size()); // slot 0 specifies end
+			return *this;
+		}
+
+		/**
+		* overloaded postfix ++
+		*/
+		iterator operator++(int) {
+
+			auto copy(*this); // copy of current position
+			++(*this);
+			return copy;
+		}
+
+		/**
+		* overloaded prefix -- (--end() is the last element)
+		*/
+		iterator& operator--() {
+
+			size_t n = container->size(); // number of slots
+			slot = slot ? prevSlot(slot, n) : lastSlot(n);
+			return *this;
+		}
+
+		/**
+		* overloaded postfix --
+		*/
+		iterator operator--(int) {
+
+			auto copy(*this); // copy of current position
+			--(*this);
+			return copy;
+		}
+
+		/**
+		* overloaded == comparison operator
+		*/
+		friend bool operator==(const iterator& left, const iterator& right) {
+			return left.slot == right.slot;
+		}
+
+		/**
+		* overloaded != comparison operator
+		*/
+		friend bool operator!=(const iterator& left, const iterator& right) {
+			return left.slot != right.slot;
+		}
+
+		/**
+		* overload dereferencing operator
+		*/
+		const T& operator*() const {
+			return container->slots[slot - 1]; // element in current slot
+		}
+
+		/**
+		* overload the operator arrow
+		*/
+		const T* operator->() const {
+			return &container->slots[slot - 1]; // element in current slot
+		}
+
+	private:
+
+		/**
+		* constructor which initializes slot and container
+		* @param k the current slot (0 for end)
+		* @param c the snapshot container
+		*/
+		iterator(size_t k = 0, const frozen_bst* c = nullptr) : slot(k), container(c) {}
+
+		size_t slot; // current slot (1-based, 0 is past-the-end)
+		const frozen_bst* container; // holding container
+	};
+
+	// lay out a sorted range in Eytzinger order
+	template <typename T, typename compare_type>
+	template <typename InputIt>
+	frozen_bst<T, compare_type>::frozen_bst(sorted_unique_t, InputIt first, InputIt last,
+		const compare_type& pred_input) : pred(pred_input) {
+
+		std::vector<const T*> sorted; // in-order view of the range
+		std::vector<T> copies; // storage for single-pass ranges
+
+		using category = typename std::iterator_traits<InputIt>::iterator_category;
+
+		if constexpr (std::is_base_of<std::forward_iterator_tag, category>::value) {
+			for (; first != last; ++first) {
+				sorted.push_back(&*first);
+			}
+		}
+		else {
+			copies.assign(first, last);
+			for (const T& v : copies) {
+				sorted.push_back(&v);
+			}
+		}
+
+		size_t n = sorted.size(); // number of slots
+		std::vector<size_t> rank(n + 1); // in-order position of each slot
+
+		// an in-order walk of the implicit tree numbers the slots
+		size_t i = 0;
+		for (size_t k = firstSlot(n); k; k = nextSlot(k, n)) {
+			rank[k] = i;
+			i = i + 1;
+		}
+
+		// emit elements slot by slot
+		slots.reserve(n);
+		for (size_t k = 1; k <= n; ++k) {
+			slots.push_back(*sorted[rank[k]]);
+		}
+	}
+
+	// hint the sixteen slots four levels below k
+	template <typename T, typename compare_type>
+	void frozen_bst<T, compare_type>::prefetch(size_t k) const {
+
+		if (16 * k <= slots.size()) { // descendants exist
+			detail::prefetch(slots.data() + 16 * k - 1);
+		}
+	}
+
+	// slot of the first element not less than key
+	template <typename T, typename compare_type>
+	template <typename K>
+	size_t frozen_bst<T, compare_type>::lowerSlot(const K& key) const {
+
+		size_t n = slots.size(); // number of slots
+		size_t k = 1; // start at the root slot
+
+		// go right (2k + 1) if the slot is less than key, else left (2k)
+		while (k <= n) {
+			prefetch(k);
+			k = 2 * k + static_cast<size_t>(pred(slots[k - 1], key));
+		}
+
+		// the answer is where the path last went left: drop the trailing
+		// right turns (1 bits) and that final left turn
+		while (k & 1) {
+			k = k >> 1;
+		}
+
+		return k >> 1;
+	}
+
+	// slot of the first element greater than key
+	template <typename T, typename compare_type>
+	template <typename K>
+	size_t frozen_bst<T, compare_type>::upperSlot(const K& key) const {
+
+		size_t n = slots.size(); // number of slots
+		size_t k = 1; // start at the root slot
+
+		// go right if key is not less than the slot, else left
+		while (k <= n) {
+			prefetch(k);
+			k = 2 * k + static_cast<size_t>(!pred(key, slots[k - 1]));
+		}
+
+		while (k & 1) { // drop the trailing right turns
+			k = k >> 1;
+		}
+
+		return k >> 1;
+	}
+
+	// slot of the element equivalent to key
+	template <typename T, typename compare_type>
+	template <typename K>
+	size_t frozen_bst<T, compare_type>::findSlot(const K& key) const {
+
+		size_t k = lowerSlot(key); // first slot not less than key
+
+		if (k && !pred(key, slots[k - 1])) { // equivalent
+			return k;
+		}
+
+		return 0; // not present
+	}
+
+	// leftmost slot of a tree of n slots
+	template <typename T, typename compare_type>
+	size_t frozen_bst<T, compare_type>::firstSlot(size_t n) {
+
+		size_t k = n ? 1 : 0; // empty tree has no slots
+
+		while (k && 2 * k <= n) { // follow left children
+			k = 2 * k;
+		}
+
+		return k;
+	}
+
+	// rightmost slot of a tree of n slots
+	template <typename T, typename compare_type>
+	size_t frozen_bst<T, compare_type>::lastSlot(size_t n) {
+
+		size_t k = n ? 1 : 0; // empty tree has no slots
+
+		while (k && 2 * k + 1 <= n) { // follow right children
+			k = 2 * k + 1;
+		}
+
+		return k;
+	}
+
+	// in-order successor of slot k
+	template <typename T, typename compare_type>
+	size_t frozen_bst<T, compare_type>::nextSlot(size_t k, size_t n) {
+
+		if (2 * k + 1 <= n) { // right subtree exists: its leftmost slot
+
+			k = 2 * k + 1;
+
+			while (2 * k <= n) {
+				k = 2 * k;
+			}
+
+			return k;
+		}
+
+		while (k & 1) { // climb while k is a right child
+			k = k >> 1;
+		}
+
+		return k >> 1; // parent of the left child (0 past the last slot)
+	}
+
+	// in-order predecessor of slot k
+	template <typename T, typename compare_type>
+	size_t frozen_bst<T, compare_type>::prevSlot(size_t k, size_t n) {
+
+		if (2 * k <= n) { // left subtree exists: its rightmost slot
+
+			k = 2 * k;
+
+			while (2 * k + 1 <= n) {
+				k = 2 * k + 1;
+			}
+
+			return k;
+		}
+
+		while (k > 1 && !(k & 1)) { // climb while k is a left child
+			k = k >> 1;
+		}
+
+		return k >> 1; // parent of the right child (0 before the first slot)
+	}
+
+	// finds value in snapshot
+	template <typename T, typename compare_type>
+	typename frozen_bst<T, compare_type>::iterator frozen_bst<T, compare_type>::find(const T& val) const {
+		return iterator(findSlot(val), this);
+	}
+
+	// finds key in snapshot without constructing T
+	template <typename T, typename compare_type>
+	template <typename K, typename C, typename>
+	typename frozen_bst<T, compare_type>::iterator frozen_bst<T, compare_type>::find(const K& key) const {
+		return iterator(findSlot(key), this);
+	}
+
+	// counts elements equivalent to value
+	template <typename T, typename compare_type>
+	size_t frozen_bst<T, compare_type>::count(const T& val) const {
+		return findSlot(val) ? 1 : 0;
+	}
+
+	// checks for an element equivalent to value
+	template <typename T, typename compare_type>
+	bool frozen_bst<T, compare_type>::contains(const T& val) const {
+		return findSlot(val) != 0;
+	}
+
+	// first element not less than value
+	template <typename T, typename compare_type>
+	typename frozen_bst<T, compare_type>::iterator frozen_bst<T, compare_type>::lower_bound(const T& val) const {
+		return iterator(lowerSlot(val), this);
+	}
+
+	// first element greater than value
+	template <typename T, typename compare_type>
+	typename frozen_bst<T, compare_type>::iterator frozen_bst<T, compare_type>::upper_bound(const T& val) const {
+		return iterator(upperSlot(val), this);
+	}
+
+	// iterator to the smallest element
+	template <typename T, typename compare_type>
+	typename frozen_bst<T, compare_type>::iterator frozen_bst<T, compare_type>::begin() const {
+		return iterator(firstSlot(slots.size()), this);
+	}
+
+	// iterator to past-the-end position
+	template <typename T, typename compare_type>
+	typename frozen_bst<T, compare_type>::iterator frozen_bst<T, compare_type>::end() const {
+		return iterator(0, this);
+	}
+}
+
+#endif
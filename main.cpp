@@ -1,4 +1,5 @@
 #include "bst.h"
+#include "frozen_bst.h"
 
 #include<iostream>
 #include<string>
@@ -101,5 +102,19 @@ int main() {
 		std::cout << s << '\n';
 	}
 
-	return 0;
+	std::cout << '\n';
+
+	std::cout << "freezing bst_4 to frozen_4." << '\n' << '\n';
+
+	// snapshot keeps end_str, so lookups order strings by their last character
+	auto frozen_4 = binarysearch::freeze(bst_4);
+
+	bool all_found = frozen_4.size() == bst_4.size(); // whether every element is found again
+	for (const auto& s : bst_4) {
+		all_found = all_found && frozen_4.find(s) != frozen_4.end() && *frozen_4.find(s) == s;
+	}
+
+	std::cout << "elements of bst_4 found in frozen_4: " << (all_found ? "all" : "not all") << '\n';
+
+	return all_found ? 0 : 1;
 }
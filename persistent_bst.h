@@ -0,0 +1,650 @@
+#ifndef PERSISTENT_BST_H
+#define PERSISTENT_BST_H
+
+#include <utility>
+#include <functional>
+#include <iterator>
+#include <type_traits>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <atomic>
+#include <random>
+
+#include "bst.h"
+
+namespace binarysearch {
+
+	/**
+	* templated persistent sorted set: insert and erase leave the tree alone
+	* and return a new version that shares every untouched subtree with it,
+	* so copying a version (a snapshot) is O(1) and an update allocates only
+	* the O(log n) expected nodes on its path (the shape is a treap)
+	* nodes are reference counted atomically, so versions may be shared and
+	* released across threads; nodes have no parent links, so iterators keep
+	* a stack of ancestors and stay valid while the version they came from lives
+	* T must be copy constructible
+	* @param T the data type of the tree
+	* @param compare_type the comparison function to compare the data
+	*/
+	template <typename T, typename compare_type = std::less<T>>
+	class persistent_bst {
+
+		struct node; // shared between versions, never modified once shared
+
+	public:
+
+		/**
+		* iterator class declaration
+		*/
+		class iterator;
+
+		/**
+		* constructor which initializes an empty version
+		* @param pred_input the comparison function to compare the data
+		*/
+		persistent_bst(const compare_type& pred_input = compare_type()) :
+			pred(pred_input), root(nullptr), tree_size(0) {}
+
+		/**
+		* destructor which drops this version's reference to its nodes
+		*/
+		~persistent_bst() { release(root); }
+
+		/**
+		* copy constructor which shares the version in O(1)
+		* @param rhs version to snapshot
+		*/
+		persistent_bst(const persistent_bst& rhs) noexcept :
+			pred(rhs.pred), root(acquire(rhs.root)), tree_size(rhs.tree_size) {}
+
+		/**
+		* move constructor
+		* @param that rvalue reference to move-from version
+		*/
+		persistent_bst(persistent_bst&& that) noexcept :
+			pred(that.pred), root(that.root), tree_size(that.tree_size) {
+			that.root = nullptr;
+			that.tree_size = 0;
+		}
+
+		/**
+		* copy/move assignment operator
+		* @param that copy/move-from version
+		*/
+		persistent_bst& operator=(persistent_bst that) & {
+			swap(that);
+			return *this;
+		}
+
+		/**
+		* checks if a version contains a particular element
+		* @param item the type T element to look for
+		* @return iterator to the element
+		*/
+		iterator find(const T& item) const;
+
+		/**
+		* checks if a version contains an element equivalent to key
+		* (only with a transparent comparator)
+		* @param key value comparable with T through compare_type
+		* @return iterator to the element
+		*/
+		template <typename K, typename C = compare_type,
+			typename = std::enable_if_t<detail::is_transparent<C>::value>>
+		iterator find(const K& key) const;
+
+		/**
+		* counts elements equivalent to a value
+		* @param item the type T element to look for
+		* @return 1 if present, 0 otherwise
+		*/
+		size_t count(const T& item) const { return findNode(item) ? 1 : 0; }
+
+		/**
+		* checks if a version contains a particular element
+		* @param item the type T element to look for
+		* @return whether an equivalent element is present
+		*/
+		bool contains(const T& item) const { return findNode(item) != nullptr; }
+
+		/**
+		* first element not less than a value
+		* @param item the type T bound
+		* @return iterator to that element, or end()
+		*/
+		iterator lower_bound(const T& item) const;
+
+		/**
+		* first element greater than a value
+		* @param item the type T bound
+		* @return iterator to that element, or end()
+		*/
+		iterator upper_bound(const T& item) const;
+
+		/**
+		* swaps two versions
+		* @param other version to swap the implicit "this" version with
+		*/
+		void swap(persistent_bst& other);
+
+		/**
+		* returns an iterator to the "smallest" element
+		* @return iterator to the leftmost node
+		*/
+		iterator begin() const;
+
+		/**
+		* returns an iterator to past-the-end position
+		* @return iterator with an empty path
+		*/
+		iterator end() const;
+
+		/**
+		* version with given lvalue added; this version is unchanged
+		* @param value the element to be added
+		* @return the new version (sharing this one's nodes if value was present)
+		*/
+		persistent_bst insert(const T& value) const;
+
+		/**
+		* version with given rvalue added; this version is unchanged
+		* @param value the element to be added
+		* @return the new version (sharing this one's nodes if value was present)
+		*/
+		persistent_bst insert(T&& value) const;
+
+		/**
+		* version without the element equivalent to a value; this version is unchanged
+		* @param item the type T element to remove
+		* @return the new version (sharing this one's nodes if item was absent)
+		*/
+		persistent_bst erase(const T& item) const;
+
+		/**
+		* version without the element equivalent to key (only with a
+		* transparent comparator); this version is unchanged
+		* @param key value comparable with T through compare_type
+		* @return the new version (sharing this one's nodes if key was absent)
+		*/
+		template <typename K, typename C = compare_type,
+			typename = std::enable_if_t<detail::is_transparent<C>::value>>
+		persistent_bst erase(const K& key) const;
+
+		/**
+		* accessor to the number of elements in this version
+		* @return number of elements
+		*/
+		size_t size() const { return tree_size; }
+
+	private:
+
+		/**
+		* constructor which adopts a reference to an existing root
+		* @param r root whose reference the version takes over
+		* @param n number of elements under r
+		* @param pred_input the comparison function to compare the data
+		*/
+		persistent_bst(node* r, size_t n, const compare_type& pred_input) :
+			pred(pred_input), root(r), tree_size(n) {}
+
+		compare_type pred; // comparison function to compare the data
+		node* root; // root of this version (one reference held)
+		size_t tree_size; // number of elements in this version
+
+		static node* acquire(node*); // add a reference (null allowed)
+		static void release(node*); // drop a reference, freeing what becomes unshared
+
+		// copy of n's element with children l and r, whose references it takes over
+		static node* adopt(const node*, node*, node*);
+
+		// node equivalent to key, or null
+		template <typename K>
+		const node* findNode(const K&) const;
+
+		// new subtree of n with value added, or null if an equivalent is present
+		template <typename V>
+		node* insertNode(node*, V&&) const;
+
+		// new subtree of n without key; found reports whether key was present
+		template <typename K>
+		node* eraseNode(node*, const K&, bool&) const;
+
+		// new subtree joining a and b, every element of a less than b's
+		static node* joinNodes(node*, node*);
+
+		template <typename K>
+		persistent_bst eraseKey(const K&) const; // erase by value or key
+
+		static uint32_t nextPriority(); // random treap priority
+	};
+
+	//nested node definition
+	template <typename T, typename compare_type>
+	struct persistent_bst<T, compare_type>::node {
+
+		/**
+		* constructor which initializes value, left, right, priority, and refs
+		*/
+		template <typename V>
+		node(V&& v, uint32_t p) :
+			value(std::forward<V>(v)), left(nullptr), right(nullptr), priority(p), refs(1) {}
+
+		const T value; // element held in the node
+		node* left; // left child (one reference held)
+		node* right; // right child (one reference held)
+		uint32_t priority; // heap order of the treap
+		std::atomic<size_t> refs; // versions and parents sharing the node
+	};
+
+	//nested iterator class definition
+	template <typename T, typename compare_type>
+	class persistent_bst<T, compare_type>::iterator { //nested iterator class
+
+		friend persistent_bst; //to allow iterator construction by persistent_bst operations
+
+		public:
+
+		// standard iterator traits (forward, read-only)
+		using iterator_category = std::forward_iterator_tag;
+		using value_type = T;
+		using difference_type = std::ptrdiff_t;
+		using pointer = const T*;
+		using reference = const T&;
+
+		/**
+		* overloaded prefix ++
+		*/
+		iterator& operator++() {
+
+			const node* n = path.back()->right; // successor is in the right subtree, if any
+			path.pop_back();
+
+			for (; n; n = n->left) { // or the nearest ancestor went left from
+				path.push_back(n);
+			}
+
+			return *this;
+		}
+
+		/**
+		* overloaded postfix ++
+		*/
+		iterator operator++(int) {
+
+			auto copy(*this); // copy of current position
+			++(*this);
+			return copy;
+		}
+
+		/**
+		* overloaded == comparison operator
+		*/
+		friend bool operator==(const iterator& left, const iterator& right) {
+			return left.current() == right.current();
+		}
+
+		/**
+		* overloaded != comparison operator
+		*/
+		friend bool operator!=(const iterator& left, const iterator& right) {
+			return left.current() != right.current();
+		}
+
+		/**
+		* overload dereferencing operator
+		*/
+		const T& operator*() const {
+			return path.back()->value;
+		}
+
+		/**
+		* overload the operator arrow
+		*/
+		const T* operator->() const {
+			return &path.back()->value;
+		}
+
+	private:
+
+		/**
+		* constructor which initializes an empty path (end)
+		*/
+		iterator() {}
+
+		const node* current() const { return path.empty() ? nullptr : path.back(); } // null at end
+
+		std::vector<const node*> path; // current node on top, below it the ancestors still to visit
+	};
+
+	// descend to the item, keeping the ancestors the path went left from
+	template <typename T, typename compare_type>
+	typename persistent_bst<T, compare_type>::iterator persistent_bst<T, compare_type>::find(const T& item) const {
+
+		iterator it; // path of the descent
+
+		for (const node* n = root; n; ) {
+
+			if (pred(item, n->value)) { // item in left subtree
+				it.path.push_back(n);
+				n = n->left;
+			}
+			else if (pred(n->value, item)) { // item in right subtree
+				n = n->right;
+			}
+			else { // equivalent
+				it.path.push_back(n);
+				return it;
+			}
+		}
+
+		return iterator();
+	}
+
+	// find by key
+	template <typename T, typename compare_type>
+	template <typename K, typename C, typename>
+	typename persistent_bst<T, compare_type>::iterator persistent_bst<T, compare_type>::find(const K& key) const {
+
+		iterator it; // path of the descent
+
+		for (const node* n = root; n; ) {
+
+			if (pred(key, n->value)) { // key in left subtree
+				it.path.push_back(n);
+				n = n->left;
+			}
+			else if (pred(n->value, key)) { // key in right subtree
+				n = n->right;
+			}
+			else { // equivalent
+				it.path.push_back(n);
+				return it;
+			}
+		}
+
+		return iterator();
+	}
+
+	// first element not less than item
+	template <typename T, typename compare_type>
+	typename persistent_bst<T, compare_type>::iterator persistent_bst<T, compare_type>::lower_bound(const T& item) const {
+
+		iterator it; // every node not less than item on the path; the last is the bound
+
+		for (const node* n = root; n; ) {
+
+			if (!pred(n->value, item)) { // value not less than item
+				it.path.push_back(n);
+				n = n->left;
+			}
+			else { // value less than item
+				n = n->right;
+			}
+		}
+
+		return it;
+	}
+
+	// first element greater than item
+	template <typename T, typename compare_type>
+	typename persistent_bst<T, compare_type>::iterator persistent_bst<T, compare_type>::upper_bound(const T& item) const {
+
+		iterator it; // every node greater than item on the path; the last is the bound
+
+		for (const node* n = root; n; ) {
+
+			if (pred(item, n->value)) { // value greater than item
+				it.path.push_back(n);
+				n = n->left;
+			}
+			else { // value not greater than item
+				n = n->right;
+			}
+		}
+
+		return it;
+	}
+
+	// swap roots, sizes and comparators
+	template <typename T, typename compare_type>
+	void persistent_bst<T, compare_type>::swap(persistent_bst& other) {
+
+		using std::swap;
+		swap(pred, other.pred);
+		swap(root, other.root);
+		swap(tree_size, other.tree_size);
+	}
+
+	// leftmost node, with its ancestors on the path
+	template <typename T, typename compare_type>
+	typename persistent_bst<T, compare_type>::iterator persistent_bst<T, compare_type>::begin() const {
+
+		iterator it; // left spine of this version
+
+		for (const node* n = root; n; n = n->left) {
+			it.path.push_back(n);
+		}
+
+		return it;
+	}
+
+	// end is an empty path
+	template <typename T, typename compare_type>
+	typename persistent_bst<T, compare_type>::iterator persistent_bst<T, compare_type>::end() const {
+		return iterator();
+	}
+
+	// insert lvalue into a new version
+	template <typename T, typename compare_type>
+	persistent_bst<T, compare_type> persistent_bst<T, compare_type>::insert(const T& value) const {
+
+		node* r = insertNode(root, value); // new path, or null if present
+		return r ? persistent_bst(r, tree_size + 1, pred) : *this;
+	}
+
+	// insert rvalue into a new version
+	template <typename T, typename compare_type>
+	persistent_bst<T, compare_type> persistent_bst<T, compare_type>::insert(T&& value) const {
+
+		node* r = insertNode(root, std::move(value)); // new path, or null if present
+		return r ? persistent_bst(r, tree_size + 1, pred) : *this;
+	}
+
+	// erase by value into a new version
+	template <typename T, typename compare_type>
+	persistent_bst<T, compare_type> persistent_bst<T, compare_type>::erase(const T& item) const {
+		return eraseKey(item);
+	}
+
+	// erase by key into a new version
+	template <typename T, typename compare_type>
+	template <typename K, typename C, typename>
+	persistent_bst<T, compare_type> persistent_bst<T, compare_type>::erase(const K& key) const {
+		return eraseKey(key);
+	}
+
+	// share a node
+	template <typename T, typename compare_type>
+	typename persistent_bst<T, compare_type>::node* persistent_bst<T, compare_type>::acquire(node* n) {
+
+		if (n) {
+			n->refs.fetch_add(1, std::memory_order_relaxed); // the caller already holds a reference
+		}
+
+		return n;
+	}
+
+	// unshare a node, freeing it and releasing its children when it was the last reference
+	template <typename T, typename compare_type>
+	void persistent_bst<T, compare_type>::release(node* n) {
+
+		// the right child is released iteratively, so recursion only follows left links
+		while (n && n->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+
+			node* right = n->right; // still to release
+			release(n->left);
+			delete n;
+			n = right;
+		}
+	}
+
+	// copy n's element above children the copy takes over
+	template <typename T, typename compare_type>
+	typename persistent_bst<T, compare_type>::node* persistent_bst<T, compare_type>::adopt(const node* n, node* l, node* r) {
+
+		node* c; // the copy
+
+		try {
+			c = new node(n->value, n->priority);
+		}
+		catch (...) { // the children would otherwise leak
+			release(l);
+			release(r);
+			throw;
+		}
+
+		c->left = l;
+		c->right = r;
+		return c;
+	}
+
+	// plain descent
+	template <typename T, typename compare_type>
+	template <typename K>
+	const typename persistent_bst<T, compare_type>::node* persistent_bst<T, compare_type>::findNode(const K& key) const {
+
+		const node* n = root; // current node
+
+		while (n) {
+
+			if (pred(key, n->value)) { // key in left subtree
+				n = n->left;
+			}
+			else if (pred(n->value, key)) { // key in right subtree
+				n = n->right;
+			}
+			else { // equivalent
+				return n;
+			}
+		}
+
+		return nullptr;
+	}
+
+	// path-copying treap insert; rotations only touch nodes created here
+	template <typename T, typename compare_type>
+	template <typename V>
+	typename persistent_bst<T, compare_type>::node* persistent_bst<T, compare_type>::insertNode(node* n, V&& value) const {
+
+		if (!n) { // insertion point
+			return new node(std::forward<V>(value), nextPriority());
+		}
+
+		if (pred(value, n->value)) { // insert into left subtree
+
+			node* l = insertNode(n->left, std::forward<V>(value));
+			if (!l) { // already present
+				return nullptr;
+			}
+
+			node* c = adopt(n, l, acquire(n->right));
+
+			if (l->priority > c->priority) { // rotate right, handing l's right child to c
+				c->left = l->right;
+				l->right = c;
+				return l;
+			}
+
+			return c;
+		}
+
+		if (pred(n->value, value)) { // insert into right subtree
+
+			node* r = insertNode(n->right, std::forward<V>(value));
+			if (!r) { // already present
+				return nullptr;
+			}
+
+			node* c = adopt(n, acquire(n->left), r);
+
+			if (r->priority > c->priority) { // rotate left, handing r's left child to c
+				c->right = r->left;
+				r->left = c;
+				return r;
+			}
+
+			return c;
+		}
+
+		return nullptr; // equivalent element present
+	}
+
+	// path-copying erase; the erased node's children are joined in its place
+	template <typename T, typename compare_type>
+	template <typename K>
+	typename persistent_bst<T, compare_type>::node* persistent_bst<T, compare_type>::eraseNode(node* n, const K& key, bool& found) const {
+
+		if (!n) { // key absent
+			found = false;
+			return nullptr;
+		}
+
+		if (pred(key, n->value)) { // erase from left subtree
+
+			node* l = eraseNode(n->left, key, found);
+			return found ? adopt(n, l, acquire(n->right)) : nullptr;
+		}
+
+		if (pred(n->value, key)) { // erase from right subtree
+
+			node* r = eraseNode(n->right, key, found);
+			return found ? adopt(n, acquire(n->left), r) : nullptr;
+		}
+
+		found = true;
+		return joinNodes(n->left, n->right);
+	}
+
+	// join along the right spine of a and the left spine of b, by priority
+	template <typename T, typename compare_type>
+	typename persistent_bst<T, compare_type>::node* persistent_bst<T, compare_type>::joinNodes(node* a, node* b) {
+
+		if (!a) {
+			return acquire(b);
+		}
+		if (!b) {
+			return acquire(a);
+		}
+
+		if (a->priority > b->priority) { // a stays on top
+
+			node* r = joinNodes(a->right, b); // joined before a's left is shared, in case it throws
+			return adopt(a, acquire(a->left), r);
+		}
+
+		node* l = joinNodes(a, b->left); // b stays on top
+		return adopt(b, l, acquire(b->right));
+	}
+
+	// new version without key
+	template <typename T, typename compare_type>
+	template <typename K>
+	persistent_bst<T, compare_type> persistent_bst<T, compare_type>::eraseKey(const K& key) const {
+
+		bool found = false; // whether key was present
+		node* r = eraseNode(root, key, found); // new path when found
+
+		return found ? persistent_bst(r, tree_size - 1, pred) : *this;
+	}
+
+	// per-thread priority stream, so versions can be built from any thread
+	template <typename T, typename compare_type>
+	uint32_t persistent_bst<T, compare_type>::nextPriority() {
+
+		thread_local std::minstd_rand gen(static_cast<uint32_t>(std::hash<const void*>()(&gen)));
+		return static_cast<uint32_t>(gen());
+	}
+}
+
+#endif
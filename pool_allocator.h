@@ -0,0 +1,312 @@
+#ifndef POOL_ALLOCATOR_H
+#define POOL_ALLOCATOR_H
+
+#include <cstddef>
+#include <new>
+#include <memory>
+#include <vector>
+#include <type_traits>
+
+namespace binarysearch {
+
+	/**
+	* fixed-size block pool carved out of contiguous slabs
+	* blocks are handed out from the newest slab and freed blocks are
+	* reused first; all slabs are returned together by release()
+	* not thread safe: intended to be owned by a single container
+	*/
+	class pool_resource {
+
+	public:
+
+		/**
+		* constructor which initializes an empty pool
+		* @param first_slab_blocks number of blocks in the first slab,
+		* each later slab doubles up to max_slab_blocks
+		*/
+		explicit pool_resource(size_t first_slab_blocks = 64) :
+			requested(0), block_size(0), next_slab_blocks(first_slab_blocks ? first_slab_blocks : 1),
+			free_list(nullptr), bump(nullptr), bump_end(nullptr), unpooled(0) {}
+
+		/**
+		* destructor which returns every slab
+		*/
+		~pool_resource() { release(); }
+
+		pool_resource(const pool_resource&) = delete;
+		pool_resource& operator=(const pool_resource&) = delete;
+
+		/**
+		* hands out one block; the first call fixes the block size, and
+		* requests of any other size or over-aligned types use aligned global new
+		* @param bytes size of the object to allocate
+		* @param align alignment of the object to allocate
+		* @return pointer to uninitialized storage
+		*/
+		void* allocate(size_t bytes, size_t align);
+
+		/**
+		* returns one block handed out by allocate
+		* @param p pointer returned by allocate
+		* @param bytes size passed to allocate
+		* @param align alignment passed to allocate
+		*/
+		void deallocate(void* p, size_t bytes, size_t align);
+
+		/**
+		* frees every slab at once, in O(slabs), whether or not the blocks
+		* were deallocated; objects still living in them are not destroyed
+		* (blocks from global new are not slabs and must be deallocated)
+		*/
+		void release();
+
+		/**
+		* accessor to the number of live blocks that bypassed the slabs
+		* @return blocks allocated from global new and not yet deallocated
+		*/
+		size_t unpooled_count() const { return unpooled; }
+
+		/**
+		* accessor to the number of slabs currently held
+		* @return number of slabs
+		*/
+		size_t slab_count() const { return slabs.size(); }
+
+		static constexpr size_t max_slab_blocks = 65536; // cap on slab growth
+
+	private:
+		struct free_block { free_block* next; }; // link stored in a freed block
+
+		bool pooled(size_t bytes, size_t align) const; // whether a request uses the pool
+		void grow(); // allocate the next slab
+
+		size_t requested; // object size served by the pool (0 until first allocation)
+		size_t block_size; // size of every block, rounded for alignment
+		size_t next_slab_blocks; // number of blocks in the next slab
+		free_block* free_list; // singly linked freed blocks
+		char* bump; // next untouched block in the newest slab
+		char* bump_end; // end of the newest slab
+		std::vector<void*> slabs; // every slab, for release()
+		size_t unpooled; // live blocks from global new, which release() cannot free
+	};
+
+	// whether a request is served from the slabs
+	inline bool pool_resource::pooled(size_t bytes, size_t align) const {
+		return bytes == requested && align <= alignof(std::max_align_t);
+	}
+
+	// hand out one block
+	inline void* pool_resource::allocate(size_t bytes, size_t align) {
+
+		if (!requested && align <= alignof(std::max_align_t)) { // first allocation fixes the block size
+
+			// round up so every block is aligned and can hold a free-list link
+			size_t size = bytes < sizeof(free_block) ? sizeof(free_block) : bytes;
+			block_size = (size + alignof(std::max_align_t) - 1) / alignof(std::max_align_t) * alignof(std::max_align_t);
+			requested = bytes;
+		}
+
+		if (!pooled(bytes, align)) { // not a pool-sized request
+
+			void* p = ::operator new(bytes, std::align_val_t(align));
+			unpooled = unpooled + 1;
+			return p;
+		}
+
+		if (free_list) { // reuse a freed block first
+
+			void* p = free_list;
+			free_list = free_list->next;
+			return p;
+		}
+
+		if (bump == bump_end) { // newest slab is used up
+			grow();
+		}
+
+		void* p = bump; // next untouched block
+		bump = bump + block_size;
+		return p;
+	}
+
+	// return one block
+	inline void pool_resource::deallocate(void* p, size_t bytes, size_t align) {
+
+		if (!pooled(bytes, align)) { // not a pool-sized request
+
+			::operator delete(p, std::align_val_t(align));
+			unpooled = unpooled - 1;
+			return;
+		}
+
+		// push block onto the free list
+		free_block* b = static_cast<free_block*>(p);
+		b->next = free_list;
+		free_list = b;
+	}
+
+	// free every slab at once
+	inline void pool_resource::release() {
+
+		for (void* slab : slabs) {
+			::operator delete(slab);
+		}
+
+		slabs.clear();
+		free_list = nullptr;
+		bump = nullptr;
+		bump_end = nullptr;
+	}
+
+	// allocate the next slab, doubling its size up to max_slab_blocks
+	inline void pool_resource::grow() {
+
+		slabs.reserve(slabs.size() + 1); // so push_back cannot throw after allocating
+		char* slab = static_cast<char*>(::operator new(block_size * next_slab_blocks));
+		slabs.push_back(slab);
+
+		bump = slab;
+		bump_end = slab + block_size * next_slab_blocks;
+
+		if (next_slab_blocks < max_slab_blocks) { // grow geometrically
+			next_slab_blocks = next_slab_blocks * 2;
+		}
+	}
+
+	/**
+	* std::allocator-compatible handle to a shared pool_resource
+	* copies (including rebound copies) share one pool and compare equal;
+	* a container copy starts a fresh pool of its own
+	* @param T the type of object allocated
+	*/
+	template <typename T>
+	class pool_allocator {
+
+		template <typename U>
+		friend class pool_allocator; // rebound copies share the pool
+
+	public:
+		using value_type = T;
+		using propagate_on_container_copy_assignment = std::true_type;
+		using propagate_on_container_move_assignment = std::true_type;
+		using propagate_on_container_swap = std::true_type;
+		using is_always_equal = std::false_type;
+
+		/**
+		* constructor which creates a new, empty pool
+		* @param first_slab_blocks number of blocks in the first slab
+		*/
+		explicit pool_allocator(size_t first_slab_blocks = 64) :
+			pool(std::make_shared<pool_resource>(first_slab_blocks)) {}
+
+		/**
+		* copy constructor which shares the pool of other
+		* @param other allocator to share the pool with
+		*/
+		pool_allocator(const pool_allocator& other) noexcept = default;
+
+		/**
+		* move constructor which shares the pool of other: a moved-from
+		* allocator still compares equal and can free what it handed out
+		* @param other allocator to share the pool with, left unchanged
+		*/
+		pool_allocator(pool_allocator&& other) noexcept : pool(other.pool) {}
+
+		/**
+		* copy assignment operator which shares the pool of other
+		* @param other allocator to share the pool with
+		* @return this allocator
+		*/
+		pool_allocator& operator=(const pool_allocator& other) noexcept = default;
+
+		/**
+		* move assignment operator which shares the pool of other, leaving
+		* other unchanged for the same reason as the move constructor
+		* @param other allocator to share the pool with
+		* @return this allocator
+		*/
+		pool_allocator& operator=(pool_allocator&& other) noexcept {
+			pool = other.pool;
+			return *this;
+		}
+
+		/**
+		* rebinding constructor which shares the pool of other
+		* @param other allocator of another value type
+		*/
+		template <typename U>
+		pool_allocator(const pool_allocator<U>& other) noexcept : pool(other.pool) {}
+
+		/**
+		* allocates storage for n objects
+		* @param n number of objects
+		* @return pointer to uninitialized storage
+		*/
+		T* allocate(size_t n) {
+			return static_cast<T*>(pool->allocate(n * sizeof(T), alignof(T)));
+		}
+
+		/**
+		* frees storage obtained from allocate
+		* @param p pointer returned by allocate
+		* @param n number of objects passed to allocate
+		*/
+		void deallocate(T* p, size_t n) {
+			pool->deallocate(p, n * sizeof(T), alignof(T));
+		}
+
+		/**
+		* a copied container gets its own pool
+		* @return allocator with a new, empty pool
+		*/
+		pool_allocator select_on_container_copy_construction() const {
+			return pool_allocator();
+		}
+
+		/**
+		* frees every slab at once if no other allocator shares the pool and
+		* every block that bypassed the slabs has been deallocated
+		* @return whether the slabs were released
+		*/
+		bool release() {
+
+			if (pool.use_count() != 1) { // another allocator may own live blocks
+				return false;
+			}
+
+			if (pool->unpooled_count() != 0) { // those blocks would leak
+				return false;
+			}
+
+			pool->release();
+			return true;
+		}
+
+		/**
+		* accessor to the shared pool
+		* @return the pool this allocator draws from
+		*/
+		pool_resource& resource() const { return *pool; }
+
+		/**
+		* overloaded == comparison operator
+		*/
+		template <typename U>
+		friend bool operator==(const pool_allocator& left, const pool_allocator<U>& right) {
+			return &left.resource() == &right.resource(); // same pool frees each other's blocks
+		}
+
+		/**
+		* overloaded != comparison operator
+		*/
+		template <typename U>
+		friend bool operator!=(const pool_allocator& left, const pool_allocator<U>& right) {
+			return &left.resource() != &right.resource();
+		}
+
+	private:
+		std::shared_ptr<pool_resource> pool; // shared block pool
+	};
+}
+
+#endif